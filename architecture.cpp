@@ -13,1389 +13,163 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 // Standard headers
-#include <tuple>
-#include <memory>
-#include <string>
-#include <vector>
-#include <iostream>
-#include <exception>
-#include <type_traits>
+#include <cstdio>
+#include <sstream>
 
-/*
-\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
- -------------------------------------------------------------------------------
-                                 MEMBER DETECTER
- -------------------------------------------------------------------------------
-////////////////////////////////////////////////////////////////////////////////
-*/
-
-// These macro are aimed to create a member detector: a class and type trait
-// that can be used to check if a type/member function/static member function
-// exists in a class. As there is an infinite number of names, it's impossible
-// to create a type trait only with the resources the language provides. Given
-// that, it's necessary to create a macro to automatically generate all classes
-// and alias from a name given as parameter.
-
-// The following macros create:
-// - Template classes that uses SFINAE and multiple inheritance to decide if
-//   the member exists in the class or in one of its superclasses.
-// - A struct inheriting from `std::integral_constant`, which have a trait
-//   compliant with STL.
-// - Two alias `has_##member_tag` and `no_##member_tag` to selectively create
-//   member functions by applying SFINAE on its parameters.
-
-/*============================================================================*/
-/*                            MEMBER TYPE DETECTOR                            */
-/*============================================================================*/
-
-#define GENERATE_HAS_MEMBER_TYPE(member)                                       \
-                                                                               \
-/*- TYPE DETECTOR ----------------------------------------------------------*/ \
-                                                                               \
-template<typename _Klass, typename _Type>                                      \
-class HasType_##member                                                         \
-{                                                                              \
- private:                                                                      \
-  template<typename _U> static std::true_type test(typename _U::_Type*);       \
-  template<typename _U> static std::false_type test(...);                      \
-                                                                               \
- public:                                                                       \
-  static constexpr bool value = decltype(test<_Klass>(nullptr))::value         \
-    || HasType_##member<typename _Klass::Base, _Type>::value;                  \
-};                                                                             \
-                                                                               \
-/*- TAGS -------------------------------------------------------------------*/ \
-                                                                               \
-struct no_##member##_tag {};                                                   \
-struct has_##member##_tag {};                                                  \
-                                                                               \
-/*- TYPE TRAIT -------------------------------------------------------------*/ \
-                                                                               \
-template<typename _Klass, typename _Type>                                      \
-struct has_type_##member                                                       \
-    : public std::integral_constant<                                           \
-               bool, HasType_##member<_Klass, _Type>::value> {                 \
-  using tag = typename std::conditional<                                       \
-                has_type_##member<_Klass, _Type>::value,                       \
-                has_##member##_tag, no_##member##_tag                          \
-              >::type;                                                         \
-}
-
-/*============================================================================*/
-/*                          MEMBER FUNCTION DETECTOR                          */
-/*============================================================================*/
-
-#define GENERATE_HAS_MEMBER_FUNCTION(member)                                   \
-                                                                               \
-template<typename _Klass, typename Dummy>                                      \
-class HasMemberFunction_##member;                                              \
-                                                                               \
-/*- NON-CONST MEMBER FUNCTION ----------------------------------------------*/ \
-                                                                               \
-template<typename _Return, typename... _Args>                                  \
-class HasMemberFunction_##member<void, _Return(_Args...)> {                    \
- public:                                                                       \
-  static constexpr bool value = false;                                         \
-};                                                                             \
-                                                                               \
-template<typename _Klass, typename _Return, typename... _Args>                 \
-class HasMemberFunction_##member<_Klass, _Return(_Args...)>                    \
-{                                                                              \
- private:                                                                      \
-  template<typename _U, _U> class Check;                                       \
-                                                                               \
-  template<typename _U>                                                        \
-  static std::true_type test(Check<_Return(_U::*)(_Args...), &_U::member>*);   \
-                                                                               \
-  template<typename _U>                                                        \
-  static std::false_type test(...);                                            \
-                                                                               \
- public:                                                                       \
-  static constexpr bool value = decltype(test<_Klass>(nullptr))::value         \
-    || HasMemberFunction_##member<typename _Klass::Base,                       \
-                                  _Return(_Args...)>::value;                   \
-};                                                                             \
-                                                                               \
-/*- CONST MEMBER FUNCTION --------------------------------------------------*/ \
-                                                                               \
-template<typename _Return, typename... _Args>                                  \
-class HasMemberFunction_##member<void, const _Return(_Args...)> {              \
- public:                                                                       \
-  static constexpr bool value = false;                                         \
-};                                                                             \
-                                                                               \
-template<typename _Klass, typename _Return, typename... _Args>                 \
-class HasMemberFunction_##member<_Klass, const _Return(_Args...)>              \
-{                                                                              \
- private:                                                                      \
-  template<typename _U, _U> class Check;                                       \
-                                                                               \
-  template<typename _U>                                                        \
-  static std::true_type test(                                                  \
-    Check<_Return(_U::*)(_Args...) const, &_U::member>*);                      \
-                                                                               \
-  template<typename _U>                                                        \
-  static std::false_type test(...);                                            \
-                                                                               \
- public:                                                                       \
-  static constexpr bool value = decltype(test<_Klass>(nullptr))::value         \
-    || HasMemberFunction_##member<typename _Klass::Base,                       \
-                          const _Return(_Args...)>::value;                     \
-};                                                                             \
-                                                                               \
-/*- TAGS -------------------------------------------------------------------*/ \
-                                                                               \
-struct no_##member##_tag {};                                                   \
-struct has_##member##_tag {};                                                  \
-                                                                               \
-/*- TYPE TRAIT -------------------------------------------------------------*/ \
-                                                                               \
-template<typename _Klass, typename Dummy>                                      \
-struct has_member_function_##member;                                           \
-                                                                               \
-template<typename _Klass, typename _Return, typename... _Args>                 \
-struct has_member_function_##member<_Klass, _Return(_Args...)>                 \
-    : public std::integral_constant<bool, HasMemberFunction_##member<          \
-                                            _Klass, _Return(_Args...)          \
-                                          >::value> {                          \
-                                                                               \
-  using tag = typename std::conditional<                                       \
-                has_member_function_##member<                                  \
-                  _Klass, _Return(_Args...)                                    \
-                >::value,                                                      \
-                has_##member##_tag, no_##member##_tag                          \
-              >::type;                                                         \
-}
-
-/*============================================================================*/
-/*                      STATIC MEMBER FUNCTION DETECTOR                       */
-/*============================================================================*/
-
-#define GENERATE_HAS_STATIC_MEMBER_FUNCTION(member)                            \
-                                                                               \
-template<typename _Klass, typename Dummy>                                      \
-class HasStaticMemberFunction_##member;                                        \
-                                                                               \
-/*- STATIC MEMBER FUNCTION -------------------------------------------------*/ \
-                                                                               \
-template<typename _Return, typename... _Args>                                  \
-class HasStaticMemberFunction_##member<void, _Return(_Args...)> {              \
- public:                                                                       \
-  static constexpr bool value = false;                                         \
-};                                                                             \
-                                                                               \
-template<typename _Klass, typename _Return, typename... _Args>                 \
-class HasStaticMemberFunction_##member<_Klass, _Return(_Args...)>              \
-{                                                                              \
- private:                                                                      \
-  template<typename _U, _U> class Check;                                       \
-                                                                               \
-  template<typename _U>                                                        \
-  static std::true_type test(Check<_Return(*)(_Args...), &_U::member>*);       \
-                                                                               \
-  template<typename _U>                                                        \
-  static std::false_type test(...);                                            \
-                                                                               \
- public:                                                                       \
-  static constexpr bool value = decltype(test<_Klass>(nullptr))::value         \
-    || HasStaticMemberFunction_##member<typename _Klass::Base,                 \
-                                _Return(_Args...)>::value;                     \
-};                                                                             \
-                                                                               \
-/*- TAGS -------------------------------------------------------------------*/ \
-                                                                               \
-struct no_##member##_tag {};                                                   \
-struct has_##member##_tag {};                                                  \
-                                                                               \
-/*- TYPE TRAIT -------------------------------------------------------------*/ \
-                                                                               \
-template<typename _Klass, typename Dummy>                                      \
-struct has_static_member_function_##member;                                    \
-                                                                               \
-template<typename _Klass, typename _Return, typename... _Args>                 \
-struct has_static_member_function_##member<_Klass, _Return(_Args...)>          \
-    : public std::integral_constant<bool, HasStaticMemberFunction_##member<    \
-                                            _Klass, _Return(_Args...)          \
-                                          >::value> {                          \
-                                                                               \
-  using tag = typename std::conditional<                                       \
-                has_static_member_function_##member<                           \
-                  _Klass, _Return(_Args...)                                    \
-                >::value,                                                      \
-                has_##member##_tag, no_##member##_tag                          \
-              >::type;                                                         \
-}
-
-/*
-\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
- -------------------------------------------------------------------------------
-                                MEMBER DELEGATOR
- -------------------------------------------------------------------------------
-////////////////////////////////////////////////////////////////////////////////
-*/
-
-// Thase macros are aimed to avoid replication of code when creating new member
-// functions for a given front-end. They require almost no knowledge about the
-// front end class, but  that the front-end superclass -end inherits from
-// std::enable_shared_from_this.
-
-/*============================================================================*/
-/*                           LATE EVALUATED BOOLEANS                          */
-/*============================================================================*/
-
-template<typename T>
-struct always_true : public std::integral_constant<bool, true> {};
-
-template<typename T>
-struct always_false : public std::integral_constant<bool, false> {};
-
-/*============================================================================*/
-/*                              NON CONST RETURN                              */
-/*============================================================================*/
-
-template <typename T> struct non_const_return { typedef T type; };
-
-template <typename T> struct non_const_return<T const  > { typedef T   type; };
-template <typename T> struct non_const_return<T const& > { typedef T&  type; };
-template <typename T> struct non_const_return<T const* > { typedef T*  type; };
-template <typename T> struct non_const_return<T const&&> { typedef T&& type; };
-
-template <typename T>
-using non_const_return_t = typename non_const_return<T>::type;
-
-template<typename T>
-non_const_return_t<T> non_const_cast(T t) {
-    return (non_const_return_t<T>) t;
-}
-
-/*============================================================================*/
-/*                              CLASS OF POINTER                              */
-/*============================================================================*/
-
-template<typename T> struct class_of;
-
-template<typename T> struct class_of<T*> {
-  using type = typename std::remove_cv<
-    typename std::remove_pointer<T*>::type>::type;
-};
-
-template<typename T>
-using class_of_t = typename class_of<T>::type;
-
-/*============================================================================*/
-/*                          FIRST PARAMETER INJECTION                         */
-/*============================================================================*/
-
-template<typename Ptr, typename Dummy> struct inject_first_parameter;
-
-template<typename Ptr, typename Klass, typename Result, typename... Args>
-struct inject_first_parameter<Ptr, Result(Klass::*)(Args...)> {
-  using type = Result(Ptr, Args...);
-};
-
-template<typename Ptr, typename Klass, typename Result, typename... Args>
-struct inject_first_parameter<Ptr, Result(Klass::*)(Args...) const> {
-  using type = const Result(Ptr, Args...);
-};
-
-/*============================================================================*/
-/*                              CONTAINER UNPACK                              */
-/*============================================================================*/
-
-template<typename Func, template<typename...> class Pack,
-         typename Ptr, typename... Args, std::size_t... I>
-auto call_helper(const Func &func, const Ptr &ptr, const Pack<Args...> &params,
-                   std::index_sequence<I...>) {
-  return func(ptr, std::get<I>(params)...);
-}
-
-template<typename Func, template<typename...> class Pack,
-         typename Ptr, typename... Args>
-auto call(const Func &func, const Ptr &ptr, const Pack<Args...> &params) {
-  return call_helper(func, ptr, params, std::index_sequence_for<Args...>{});
-}
-
-/*============================================================================*/
-/*                    MEMBER FUNCTION DELEGATOR GENERATION                    */
-/*============================================================================*/
-
-#define GENERATE_MEMBER_FUNCTION_DELEGATOR(method, delegatedObject)            \
-                                                                               \
-template<typename... Args>                                                     \
-inline auto method##Impl(Args&&... args) const                                 \
-    -> decltype(non_const_cast(this)->method(std::forward<Args>(args)...)) {   \
-  return (this->delegatedObject)->method(                                      \
-    std::static_pointer_cast<class_of_t<decltype(this)>>(                      \
-      const_cast<class_of_t<decltype(this)>*>(this)->shared_from_this()),      \
-    std::forward<Args>(args)...);                                              \
-}                                                                              \
-                                                                               \
-template<typename... Args>                                                     \
-inline auto method##Impl(Args&&... args)                                       \
-    -> decltype(this->method(std::forward<Args>(args)...)) {                   \
-  return (non_const_return_t<decltype(this->method(args...))>) (               \
-    static_cast<const class_of_t<decltype(this)> *>(this)->method##Impl(       \
-      std::forward<Args>(args)...));                                           \
-}
-
-/*============================================================================*/
-/*                       MEMBER FUNCTION DELEGATOR CALL                       */
-/*============================================================================*/
-
-#define CALL_MEMBER_FUNCTION_DELEGATOR(method, ...)                            \
-do { return method##Impl(__VA_ARGS__); } while (false)
-
-/*============================================================================*/
-/*                STATIC MEMBER FUNCTION DELEGATOR GENERATION                 */
-/*============================================================================*/
-
-#define GENERATE_STATIC_MEMBER_FUNCTION_DELEGATOR(method, delegatedClass)      \
-                                                                               \
-GENERATE_HAS_STATIC_MEMBER_FUNCTION(delegate);                                 \
-GENERATE_HAS_STATIC_MEMBER_FUNCTION(method##Alt);                              \
-                                                                               \
-template<typename... Args>                                                     \
-inline auto method##Impl(Args&&... args) const                                 \
-    -> decltype(non_const_cast(this)->method(std::forward<Args>(args)...)) {   \
-  if (delegate()) {                                                            \
-    return delegatedClass::method(                                             \
-      std::static_pointer_cast<class_of_t<decltype(this)>>(                    \
-        const_cast<class_of_t<decltype(this)>*>(this)->shared_from_this()),    \
-      std::forward<Args>(args)...);                                            \
-  }                                                                            \
-  return method##Alt();                                                        \
-}                                                                              \
-                                                                               \
-template<typename... Args>                                                     \
-inline auto method##Impl(Args&&... args)                                       \
-    -> decltype(this->method(std::forward<Args>(args)...)) {                   \
-  return (non_const_return_t<                                                  \
-            decltype(this->method(std::forward<Args>(args)...))>) (            \
-    static_cast<const class_of_t<decltype(this)> *>(this)->method##Impl(       \
-      std::forward<Args>(args)...));                                           \
-}                                                                              \
-                                                                               \
-inline auto method##Impl() const                                               \
-    -> decltype(non_const_cast(this)->method()) {                              \
-  return method##Alt();                                                        \
-}                                                                              \
-                                                                               \
-inline auto method##Impl()                                                     \
-    -> decltype(this->method()) {                                              \
-  return (non_const_return_t<decltype(this->method())>) (                      \
-    static_cast<const class_of_t<decltype(this)>*>(this)->method##Impl());     \
-}                                                                              \
-                                                                               \
-template<typename _T = void>                                                   \
-inline constexpr auto method##Alt(_T* = nullptr) const                         \
-    -> decltype(typename std::enable_if<                                       \
-                  !has_static_member_function_##method##Alt<                   \
-                    class_of_t<decltype(this)>, void()                         \
-                  >::value                                                     \
-                >::type(),                                                     \
-                non_const_cast(this)->method()) {                              \
-  throw std::logic_error("Cannot call '" #method "' without parameters");      \
-}                                                                              \
-                                                                               \
-template<typename _T = void>                                                   \
-inline constexpr auto method##Alt(_T* = nullptr)                               \
-    -> decltype(typename std::enable_if<                                       \
-                  !has_static_member_function_##method##Alt<                   \
-                    class_of_t<decltype(this)>, void()                         \
-                  >::value                                                     \
-                >::type(),                                                     \
-                non_const_cast(this)->method()) {                              \
-  return (non_const_return_t<decltype(this->method())>) (                      \
-    static_cast<const class_of_t<decltype(this)>*>(this)->method##Impl());     \
-}                                                                              \
-                                                                               \
-template<typename _T = void>                                                   \
-inline constexpr auto delegate(_T* = nullptr) const                            \
-    -> decltype(typename std::enable_if<                                       \
-                  !has_static_member_function_delegate<                        \
-                    class_of_t<decltype(this)>, void()                         \
-                  >::value                                                     \
-                >::type(), bool()) {                                           \
-  return true;                                                                 \
-}                                                                              \
-                                                                               \
-template<typename _T = void>                                                   \
-inline constexpr auto delegate(_T* = nullptr)                                  \
-    -> decltype(typename std::enable_if<                                       \
-                  !has_static_member_function_delegate<                        \
-                    class_of_t<decltype(this)>, void()                         \
-                  >::value                                                     \
-                >::type(), bool()) {                                           \
-  return (non_const_return_t<decltype(this->method())>) (                      \
-    static_cast<const class_of_t<decltype(this)>*>(this)->method##Impl());     \
-}
-
-/*============================================================================*/
-/*                   STATIC MEMBER FUNCTION DELEGATOR CALL                    */
-/*============================================================================*/
-
-#define CALL_STATIC_MEMBER_FUNCTION_DELEGATOR(method, ...)                     \
-do { return method##Impl(__VA_ARGS__); } while (false)
-
-/*
-\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
- -------------------------------------------------------------------------------
-                                 COMMON CLASSES
- -------------------------------------------------------------------------------
-////////////////////////////////////////////////////////////////////////////////
-*/
-
-/* CLASS Target ***************************************************************/
-
-class Target {
-};
-
-/* CLASS Spot *****************************************************************/
-
-class Spot {
-};
-
-/*
-\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
- -------------------------------------------------------------------------------
-                                 FOO FRONT-END
- -------------------------------------------------------------------------------
-////////////////////////////////////////////////////////////////////////////////
-*/
-
-/* CLASS Foo ******************************************************************/
-
-// Forward declaration
-template<typename T>
-class Foo;
-
-// Alias
-template<typename T>
-using FooPtr = std::shared_ptr<Foo<T>>;
-
-/**
- * @class Foo
- * Interface for implementation of Foo front-end
- */
-template<typename T>
-class Foo : public std::enable_shared_from_this<Foo<T>> {
- public:
-  // Virtual methods
-  virtual void method(const std::string &msg = "") const = 0;
-};
-
-/* CLASS SimpleFoo ************************************************************/
-
-// Forward declaration
-template<typename T, typename M>
-class SimpleFoo;
-
-// Alias
-template<typename T, typename M>
-using SimpleFooPtr = std::shared_ptr<SimpleFoo<T, M>>;
-
-/**
- * @class SimpleFoo
- * Simple implementation of Foo front-end
- */
-template<typename T, typename M>
-class SimpleFoo : public Foo<T> {
- public:
-  // Alias
-  using MPtr = std::shared_ptr<M>;
-
-  // Constructor
-  SimpleFoo(MPtr m)
-      : _m(std::move(m)) {
-  }
-
-  // Overriden methods
-  void method(const std::string &msg) const override {
-    CALL_MEMBER_FUNCTION_DELEGATOR(method, msg);
-  }
-
- protected:
-  // Instance variables
-  MPtr _m;
-
- private:
-  GENERATE_MEMBER_FUNCTION_DELEGATOR(method, _m)
-};
-
-/* CLASS CachedFoo ************************************************************/
-
-// Forward declaration
-template<typename T, typename M>
-class CachedFoo;
-
-// Alias
-template<typename T, typename M>
-using CachedFooPtr = std::shared_ptr<CachedFoo<T, M>>;
-
-/**
- * @class CachedFoo
- * Cached implementation of Foo front-end
- */
-template<typename T, typename M>
-class CachedFoo : public SimpleFoo<T, M> {
- public:
-  // Alias
-  using MPtr = std::shared_ptr<M>;
-  using Cache = typename M::Cache;
-
-  // Constructor
-  CachedFoo(MPtr m, Cache cache = Cache())
-      : SimpleFoo<T,M>(std::move(m)), _cache(std::move(cache)) {
-  }
-
-  // Overriden methods
-  void method(const std::string &msg) const override {
-    CALL_MEMBER_FUNCTION_DELEGATOR(method, msg);
-  }
-
-  // Concrete methods
-  Cache cache() {
-    return _cache;
-  }
-
- protected:
-  // Instance variables
-  Cache _cache;
-
- private:
-  GENERATE_MEMBER_FUNCTION_DELEGATOR(method, _m)
-};
-
-/*
-\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
- -------------------------------------------------------------------------------
-                               VISITOR FRONT-END
- -------------------------------------------------------------------------------
-////////////////////////////////////////////////////////////////////////////////
-*/
-
-/* CLASS Visitor **************************************************************/
-
-// Forward declaration
-class Visitor;
-
-// Alias
-using VisitorPtr = std::shared_ptr<Visitor>;
-
-// Forward declaration
-class Baz;
-class BarDerived;
-class BarReusing;
-
-class Visitor {
- public:
-  // Purely virtual functions
-  virtual void visit(std::shared_ptr<Baz> top) = 0;
-  virtual void visit(std::shared_ptr<BarDerived> top) = 0;
-  virtual void visit(std::shared_ptr<BarReusing> top) = 0;
-};
-
-/* CLASS Acceptor *************************************************************/
-
-// Forward declaration
-class Acceptor;
-
-// Alias
-using AcceptorPtr = std::shared_ptr<Acceptor>;
-
-/**
- * @class Acceptor
- * Interface for implementation of Acceptor front-end
- */
-class Acceptor : public std::enable_shared_from_this<Acceptor> {
- public:
-  // Enum classes
-  enum class traversal { pre_order, post_order };
-
-  // Concrete methods
-  void pre_order() {
-    accept(traversal::pre_order);
-  }
-
-  void post_order() {
-    accept(traversal::post_order);
-  }
-
-  // Virtual methods
-  virtual void accept(const traversal& type = traversal::post_order) = 0;
-};
-
-/* CLASS SimpleAcceptor *******************************************************/
-
-// Forward declaration
-template<typename M>
-class SimpleAcceptor;
-
-// Alias
-template<typename M>
-using SimpleAcceptorPtr = std::shared_ptr<SimpleAcceptor<M>>;
-
-/**
- * @class SimpleAcceptor
- * Simple implementation of Acceptor front-end
- */
-template<typename M>
-class SimpleAcceptor : public Acceptor {
- public:
-  // Alias
-  using MPtr = std::shared_ptr<M>;
-
-  // Constructor
-  SimpleAcceptor(MPtr m, VisitorPtr visitor)
-      : _m(std::move(m)), _visitor(visitor) {
-  }
-
-  // Overriden methods
-  void accept(const Acceptor::traversal& type) override {
-    CALL_MEMBER_FUNCTION_DELEGATOR(accept, type);
-  }
-
-  // Concrete methods
-  VisitorPtr visitor() {
-    return _visitor;
-  }
-
- protected:
-  // Instance variables
-  MPtr _m;
-  VisitorPtr _visitor;
-
- private:
-  GENERATE_MEMBER_FUNCTION_DELEGATOR(accept, _m)
-};
-
-/*
-\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
- -------------------------------------------------------------------------------
-                               CREATOR ALGORITHMS
- -------------------------------------------------------------------------------
-////////////////////////////////////////////////////////////////////////////////
-*/
-
-/* STRUCT creator_algorithm_tag ***********************************************/
-
-struct creator_algorithm_tag {};
-
-struct creator_carriage_tag : public creator_algorithm_tag {};
-struct creator_newline_tag : public creator_algorithm_tag {};
-struct creator_space_tag : public creator_algorithm_tag {};
-struct creator_tab_tag : public creator_algorithm_tag {};
-
-/*
-\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
- -------------------------------------------------------------------------------
-                               CREATOR FRONT-END
- -------------------------------------------------------------------------------
-////////////////////////////////////////////////////////////////////////////////
-*/
-
-/* CLASS Creator **************************************************************/
-
-// Forward declaration
-template<typename T, typename M>
-class Creator;
-
-// Alias
-template<typename T, typename M>
-using CreatorPtr = std::shared_ptr<Creator<T, M>>;
-
-/**
- * @class Creator
- * Interface for implementation of Creator front-end
- */
-template<typename T, typename M>
-class Creator : public std::enable_shared_from_this<Creator<T, M>> {
- public:
-  // Alias
-  using Base = void;
-  using MPtr = std::shared_ptr<M>;
-
-  // Purely virtual methods
-  virtual std::vector<std::string>& words() = 0;
-  virtual const std::vector<std::string>& words() const = 0;
-  virtual void add_word(const std::string& word) = 0;
-
-  // Concrete methods
-  template<typename... Args>
-  MPtr create(Args&&... args) const {
-    CALL_STATIC_MEMBER_FUNCTION_DELEGATOR(create, std::forward<Args>(args)...);
-  }
-
- protected:
-  // Purely virtual methods
-  virtual bool delegate() const = 0;
-  virtual MPtr createAlt() const = 0;
-
-  GENERATE_STATIC_MEMBER_FUNCTION_DELEGATOR(create, M)
-};
-
-/* CLASS SimpleCreator ********************************************************/
-
-// Forward declaration
-template<typename T, typename M>
-class SimpleCreator;
-
-// Alias
-template<typename T, typename M>
-using SimpleCreatorPtr = std::shared_ptr<SimpleCreator<T, M>>;
-
-/**
- * @class SimpleCreator
- * Simple implementation of Creator front-end
- */
-template<typename T, typename M>
-class SimpleCreator : public Creator<T, M> {
- public:
-  // Alias
-  using Base = Creator<T, M>;
-  using MPtr = std::shared_ptr<M>;
-
-  using Self = SimpleCreator<T, M>;
-  using SelfPtr = std::shared_ptr<Self>;
-
-  // Static methods
-  template<typename... Args>
-  static SelfPtr make(Args&&... args) {
-    return SelfPtr(new Self(std::forward<Args>(args)...));
-  }
-
-  // Overriden methods
-  std::vector<std::string>& words() override {
-    return const_cast<std::vector<std::string>&>(
-      static_cast<const Self *>(this)->words());
-  }
-
-  const std::vector<std::string>& words() const override {
-    return _words;
-  }
-
-  void add_word(const std::string &word) override {
-    _words.push_back(word);
-  }
-
- protected:
-  // Instance variables
-  std::vector<std::string> _words;
-
-  // Overriden methods
-  bool delegate() const override {
-    return true;
-  }
-
-  MPtr createAlt() const override {
-    throw std::logic_error("Cannot create M without parameters");
-  }
-};
-
-/* CLASS CachedCreator ********************************************************/
-
-// Forward declaration
-template<typename T, typename M, typename... Params>
-class CachedCreator;
-
-// Alias
-template<typename T, typename M, typename... Params>
-using CachedCreatorPtr = std::shared_ptr<CachedCreator<T, M, Params...>>;
-
-/**
- * @class CachedCreator
- * Cached implementation of Creator front-end
- */
-template<typename T, typename M, typename... Params>
-class CachedCreator : public SimpleCreator<T, M> {
- public:
-  // Alias
-  using Base = SimpleCreator<T, M>;
-  using MPtr = std::shared_ptr<M>;
-
-  using Self = CachedCreator<T, M, Params...>;
-  using SelfPtr = std::shared_ptr<Self>;
-
-  // Static methods
-  template<typename... Args>
-  static SelfPtr make(Args&&... args) {
-    return SelfPtr(new Self(std::forward<Args>(args)...));
-  }
-
- protected:
-  // Instance variables
-  std::tuple<Params...> _params;
-
-  // Constructors
-  CachedCreator(Params&&... params)
-    : _params(std::forward<Params>(params)...) {
-  }
-
-  // Overriden methods
-  MPtr createAlt() const override {
-    CreatorPtr<T, M> ptr = std::static_pointer_cast<Self>(
-      const_cast<Self*>(this)->shared_from_this());
-
-    auto func = [](auto&&... args) {
-      return M::create(std::forward<decltype(args)>(args)...);
-    };
-
-    return call(func, ptr, _params);
-  }
-};
-
-/* CLASS FixedCreator *********************************************************/
-
-/**
- * @class FixedCreator
- * Fixed implementation of Creator front-end
- */
-template<typename T, typename M>
-class FixedCreator : public Creator<T, M> {
- public:
-  // Alias
-  using Base = Creator<T, M>;
-  using MPtr = std::shared_ptr<M>;
-
-  using Self = FixedCreator;
-  using SelfPtr = std::shared_ptr<Self>;
-
-  // Static methods
-  template<typename... Args>
-  static SelfPtr make(Args&&... args) {
-    return SelfPtr(new Self(std::forward<Args>(args)...));
-  }
-
-  // Overriden methods
-  std::vector<std::string>& words() override {
-    return const_cast<std::vector<std::string>&>(
-      static_cast<const Self *>(this)->words());
-  }
-
-  const std::vector<std::string>& words() const override {
-    throw std::logic_error("Should not be called");
-  }
-
-  void add_word(const std::string& /* word */) override {
-    /* do nothing */
-  }
-
- protected:
-  // Instance variables
-  MPtr _m;
-
-  // Constructors
-  FixedCreator(MPtr m) : _m(std::move(m)) {
-  }
-
-  // Overriden methods
-  bool delegate() const override {
-    return false;
-  }
-
-  MPtr createAlt() const override {
-    return M::make(*(_m.get()));
-  }
-};
+// Internal headers
+#include "architecture.hpp"
 
 /*
 \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
  -------------------------------------------------------------------------------
-                               HIERARCHY BACK-END
+                                  TEST MODELS
  -------------------------------------------------------------------------------
 ////////////////////////////////////////////////////////////////////////////////
-*/
-
-/* CLASS Top ******************************************************************/
-
-// Forward declaration
-class Top;
-
-// Alias
-using TopPtr = std::shared_ptr<Top>;
-
-/**
- * @class Top
- * Top of the class hierarchy
- */
-class Top {
- public:
-  // Destructor
-  virtual ~Top() {}
-
-  // Purely virtual methods
-  virtual AcceptorPtr acceptor(VisitorPtr visitor) = 0;
-  virtual void dump() = 0;
-};
-
-/* CLASS TopCrtp **************************************************************/
-
-// Forward declaration
-template<typename Derived>
-class TopCrtp;
-
-// Alias
-template<typename Derived>
-using TopCrtpPtr = std::shared_ptr<TopCrtp<Derived>>;
-
-/**
- * @class TopCrtp
- * Implementation of visitor, using CRTP to inject methods in subclasses
- */
-template<typename Derived>
-class TopCrtp
-    : public std::enable_shared_from_this<TopCrtp<Derived>>,
-      public virtual Top {
- public:
-  // Alias
-  using Base = void;
-  using Cache = int;
-  using DerivedPtr = std::shared_ptr<Derived>;
-
-  // Static methods
-  static CreatorPtr<Target, Derived> targetCreator() {
-    return SimpleCreator<Target, Derived>::make();
-  }
-
-  static CreatorPtr<Target, Derived> targetCreator(DerivedPtr model) {
-    return FixedCreator<Target, Derived>::make(model);
-  }
-
-  template<typename Tag, typename... Args>
-  static CreatorPtr<Target, Derived> targetCreator(Tag, Args&&... args) {
-    return CachedCreator<Target, Derived, Tag, Args...>::make(
-      Tag{}, std::forward<Args>(args)...);
-  }
-
-  static CreatorPtr<Spot, Derived> spotCreator() {
-    return SimpleCreator<Spot, Derived>::make();
-  }
-
-  static CreatorPtr<Target, Derived> spotCreator(DerivedPtr model) {
-    return FixedCreator<Target, Derived>::make(model);
-  }
-
-  template<typename Tag, typename... Args>
-  static CreatorPtr<Spot, Derived> spotCreator(Tag, Args&&... args) {
-    return CachedCreator<Spot, Derived, Tag, Args...>::make(
-      Tag{}, std::forward<Args>(args)...);
-  }
-
-  // Overriden methods
-  AcceptorPtr acceptor(VisitorPtr visitor) override {
-    return std::make_shared<SimpleAcceptor<Derived>>(
-      this->make_shared(), visitor);
-  }
-
-  void dump() override {
-    std::cout << _text << std::endl;
-  }
-
-  // Virtual methods
-  virtual void accept(SimpleAcceptorPtr<Derived> acceptor,
-                      const Acceptor::traversal& /* type */) {
-    acceptor->visitor()->visit(this->make_shared());
-  }
-
- protected:
-  // Instance variables
-  std::string _text;
-
-  // Static methods
-  static std::string buildMessage(const std::vector<std::string> &words,
-                                  const std::string &divisor) {
-    std::string text;
-    if (!words.empty()) {
-      for (unsigned int i = 0; i < words.size()-1; i++)
-        text += words[i] + divisor;
-      text += words.back();
-    }
-    return text;
-  }
-
-  // Constructors
-  TopCrtp(const std::string &text = {})
-    : _text(text) {
-  }
-
-  // Concrete methods
-  DerivedPtr make_shared() {
-    return std::static_pointer_cast<Derived>(
-      static_cast<Derived *>(this)->shared_from_this());
-  }
-};
-
-/* CLASS Baz ******************************************************************/
-
-// Forward declaration
-class Baz;
-
-// Alias
-using BazPtr = std::shared_ptr<Baz>;
-
-/**
- * @class Baz
- * Basic son of Top
- */
-class Baz : public TopCrtp<Baz> {
- public:
-  // Alias
-  using Base = TopCrtp<Baz>;
-
-  using Self = Baz;
-  using SelfPtr = std::shared_ptr<Self>;
-
-  // Static methods
-  template<typename... Args>
-  static SelfPtr make(Args&&... args) {
-    return SelfPtr(new Self(std::forward<Args>(args)...));
-  }
-
-  static SelfPtr create(CreatorPtr<Target, Self> creator, creator_newline_tag) {
-    return Self::make(buildMessage(creator->words(), "\n"));
-  }
-
-  static SelfPtr create(CreatorPtr<Target, Self> creator, creator_space_tag) {
-    return Self::make(buildMessage(creator->words(), " "));
-  }
-
- protected:
-  // Constructor inheritance
-  using Base::TopCrtp;
-};
-
-/* CLASS Bar ******************************************************************/
-
-// Forward declaration
-class Bar;
-
-// Alias
-using BarPtr = std::shared_ptr<Bar>;
-
-/**
- * @class Bar
- * Complex son of Top, with definition of new front-end
- */
-class Bar : public virtual Top {
- public:
-  // Destructor
-  virtual ~Bar() {}
-
-  // Purely virtual methods
-  virtual FooPtr<Target> targetFoo(bool cached) = 0;
-  virtual FooPtr<Spot> spotFoo(bool cached) = 0;
-};
-
-/* CLASS BarCrtp **************************************************************/
-
-// Forward declaration
-template<typename Derived>
-class BarCrtp;
-
-// Alias
-template<typename Derived>
-using BarCrtpPtr = std::shared_ptr<BarCrtp<Derived>>;
-
-/**
- * @class BarCrtp
- * Implementation of front-end, using CRTP to inject methods in subclasses
- */
-template<typename Derived>
-class BarCrtp : public TopCrtp<Derived>, public virtual Bar {
- public:
-  // Alias
-  using Base = TopCrtp<Derived>;
-
-  // Overriding methods
-  FooPtr<Target> targetFoo(bool cached = true) override {
-    if (cached)
-      return std::make_shared<CachedFoo<Target, Derived>>(this->make_shared());
-    return std::make_shared<SimpleFoo<Target, Derived>>(this->make_shared());
-  }
-
-  FooPtr<Spot> spotFoo(bool cached = true) override {
-    if (cached)
-      return std::make_shared<CachedFoo<Spot, Derived>>(this->make_shared());
-    return std::make_shared<SimpleFoo<Spot, Derived>>(this->make_shared());
-  }
-
-  void messageBroadcast(const std::string& msg) const {
-    if (!msg.empty())
-      std::cout << "Transmiting message: " << msg << std::endl;
-  }
-
-  // Virtual methods
-  virtual void method(SimpleFooPtr<Target, Derived> /* simple_foo */,
-                      const std::string &msg) const {
-    std::cout << "Running simple for Target in BarCrtp" << std::endl;
-    messageBroadcast(msg);
-  }
-
-  virtual void method(CachedFooPtr<Target, Derived> cached_foo,
-                      const std::string &msg) const {
-    std::cout << "Running cached for Target in BarCrtp" << std::endl;
-    std::cout << "Cache: " << typeid(cached_foo->cache()).name() << std::endl;
-    messageBroadcast(msg);
-  }
-
-  virtual void method(SimpleFooPtr<Spot, Derived> /* simple_foo */,
-                      const std::string &msg) const {
-    std::cout << "Running simple for Spot in BarCrtp" << std::endl;
-    messageBroadcast(msg);
-  }
+*/
 
-  virtual void method(CachedFooPtr<Spot, Derived> cached_foo,
-                      const std::string &msg) const {
-    std::cout << "Running cached for Spot in BarCrtp" << std::endl;
-    std::cout << "Cache: " << typeid(cached_foo->cache()).name() << std::endl;
-    messageBroadcast(msg);
-  }
+/* CLASS BarCounting **********************************************************/
 
+/**
+ * @class BarCounting
+ * Bar handing out handles counted intrusively, with the given policy. When
+ * confined to a single thread, its front-ends memoize in a plain MemoTable
+ * (see TopCrtp)
+ */
+template<typename RefCount>
+class BarCounting
+    : public BarCrtp<BarCounting<RefCount>, intrusive_handles<RefCount>> {
  protected:
-  // Constructor inheritance
-  using Base::TopCrtp;
-};
-
-/* CLASS BarDerived ***********************************************************/
+  // Constructors
+  BarCounting() = default;
+  BarCounting(const BarCounting &) = default;
 
-// Forward declaration
-class BarDerived;
+  // Friends
+  friend struct allocated_access;
+};
 
-// Alias
-using BarDerivedPtr = std::shared_ptr<BarDerived>;
+/* CLASS BazNesting ***********************************************************/
 
 /**
- * @class BarDerived
- * Class "overriding" parent implementation
+ * @class BazNesting
+ * Model whose creation with newlines asks its creator for a model with spaces
  */
-class BarDerived : public BarCrtp<BarDerived> {
+class BazNesting : public TopCrtp<BazNesting> {
  public:
   // Alias
-  using Base = BarCrtp<BarDerived>;
-  using Cache = double;
-
-  using Self = BarDerived;
+  using Self = BazNesting;
   using SelfPtr = std::shared_ptr<Self>;
 
-  using State = BarDerived;
-  using StatePtr = BarDerivedPtr;
-
   // Static methods
-  template<typename... Args>
-  static SelfPtr make(Args&&... args) {
-    return SelfPtr(new Self(std::forward<Args>(args)...));
+  static SelfPtr create(CreatorPtr<Target, Self> creator, creator_space_tag) {
+    return make(buildMessage(creator->words(), " "));
   }
 
-  static SelfPtr create(
-      CreatorPtr<Target, Self> creator, creator_carriage_tag,
-      const std::vector<CreatorPtr<Target, State>> &state_creators = {}) {
-    return Self::make(
-      buildMessage(creator->words(), "\r"),
-      initializeStates(state_creators, creator->words())
-    );
+  static SelfPtr create(CreatorPtr<Target, Self> creator,
+                        creator_newline_tag) {
+    return make(creator->create(creator_space_tag{})->rope());
   }
 
-  static SelfPtr create(
-      CreatorPtr<Target, Self> creator, creator_newline_tag,
-      const std::vector<CreatorPtr<Target, State>> &state_creators = {}) {
-    return Self::make(
-      buildMessage(creator->words(), "\n"),
-      initializeStates(state_creators, creator->words())
-    );
-  }
+ protected:
+  // Constructor inheritance
+  using TopCrtp::TopCrtp;
 
-  static SelfPtr create(
-      CreatorPtr<Target, Self> creator, creator_space_tag,
-      const std::vector<CreatorPtr<Target, State>> &state_creators = {}) {
-    return Self::make(
-      buildMessage(creator->words(), " "),
-      initializeStates(state_creators, creator->words())
-    );
-  }
+  // Friends
+  friend struct allocated_access;
+};
 
-  // Constructors
-  BarDerived(const std::string &text = {},
-             const std::vector<StatePtr>& states = {})
-      : BarCrtp(text), _states(states) {
-  }
+/* CLASS BarAnnouncing ********************************************************/
+
+/**
+ * @class BarAnnouncing
+ * BarDerived announcing its own traversal, overriding only accept
+ */
+class BarAnnouncing : public BarDerived {
+ public:
+  // Constructor inheritance
+  using BarDerived::BarDerived;
 
   // Overriden methods
+  using BarDerived::accept;
+
   void accept(SimpleAcceptorPtr<BarDerived> acceptor,
               const Acceptor::traversal& type) override {
-    if (type == Acceptor::traversal::pre_order) compose_accept(acceptor, type);
-    acceptor->visitor()->visit(this->make_shared());
-    if (type == Acceptor::traversal::post_order) compose_accept(acceptor, type);
-  }
-
-  void method(SimpleFooPtr<Target, BarDerived> /* simple_foo */,
-              const std::string &msg) const override {
-    std::cout << "Running simple for Target in BarDerived" << std::endl;
-    messageBroadcast(msg);
-  }
-
-  void method(CachedFooPtr<Target, BarDerived> cached_foo,
-              const std::string &msg) const override {
-    std::cout << "Running cached for Target in BarDerived" << std::endl;
-    std::cout << "Cache: " << typeid(cached_foo->cache()).name() << std::endl;
-    messageBroadcast(msg);
-  }
-
-  void method(SimpleFooPtr<Spot, BarDerived> /* simple_foo */,
-              const std::string &msg) const override {
-    std::cout << "Running simple for Spot in BarDerived" << std::endl;
-    messageBroadcast(msg);
-  }
-
-  void method(CachedFooPtr<Spot, BarDerived> cached_foo,
-              const std::string &msg) const override {
-    std::cout << "Running cached for Spot in BarDerived" << std::endl;
-    std::cout << "Cache: " << typeid(cached_foo->cache()).name() << std::endl;
-    messageBroadcast(msg);
-  }
-
- private:
-  // Instance variables
-  std::vector<StatePtr> _states;
-
-  // Static methods
-  static std::vector<StatePtr> initializeStates(
-      const std::vector<CreatorPtr<Target, State>> &state_creators,
-      const std::vector<std::string> &words) {
-    if (!state_creators.empty()) {
-      unsigned int size = state_creators.size();
-      for (unsigned int i = 0; i < words.size(); i++) {
-        state_creators[i % size]->add_word(words[i]);
-      }
-    }
-
-    std::vector<StatePtr> states;
-    for (const auto &state_creator : state_creators) {
-      states.push_back(state_creator->create());
-    }
-
-    return states;
-  }
-
-  // Concrete methods
-  void compose_accept(SimpleAcceptorPtr<BarDerived> acceptor,
-                      const Acceptor::traversal& type) {
-    for (auto state : _states)
-      state->acceptor(acceptor->visitor())->accept(type);
+    std::cout << "Accepting BarAnnouncing" << std::endl;
+    BarDerived::accept(acceptor, type);
   }
 };
 
-/* CLASS BarReusing ***********************************************************/
-
-// Forward declaration
-class BarReusing;
-
-// Alias
-using BarReusingPtr = std::shared_ptr<BarReusing>;
+/* CLASS BarLending ***********************************************************/
 
 /**
- * @class BarReusing
- * Class reusing parent implementation
+ * @class BarLending
+ * Bar overriding only the borrowed simple Foo front-end for Target
  */
-class BarReusing : public BarCrtp<BarReusing> {
+class BarLending : public BarCrtp<BarLending> {
  public:
-  // Alias
-  using Base = BarCrtp<BarReusing>;
-
-  using Self = BarReusing;
-  using SelfPtr = std::shared_ptr<Self>;
-
-  // Static methods
-  template<typename... Args>
-  static SelfPtr make(Args&&... args) {
-    return SelfPtr(new Self(std::forward<Args>(args)...));
-  }
-
-  static SelfPtr create(CreatorPtr<Target, Self> creator, creator_newline_tag) {
-    return Self::make(buildMessage(creator->words(), "\r\n"));
-  }
+  // Concrete methods
+  using BarCrtp::method;
 
-  static SelfPtr create(CreatorPtr<Target, Self> creator, creator_tab_tag) {
-    return Self::make(buildMessage(creator->words(), "\t"));
+  void method(const SimpleFoo<Target, BarLending> & /* simple_foo */,
+              const std::string &msg) const {
+    std::cout << "Running borrowed simple for Target in BarLending"
+              << std::endl;
+    messageBroadcast(msg);
   }
-
- protected:
-  // Constructor inheritance
-  using Base::BarCrtp;
 };
 
-/*
-\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
- -------------------------------------------------------------------------------
-                              VISITOR IMPLEMENTATION
- -------------------------------------------------------------------------------
-////////////////////////////////////////////////////////////////////////////////
-*/
+/* CLASS DetectedBase *********************************************************/
 
-/* CLASS FooVisitor ***********************************************************/
+// Classes whose members are found by the member detectors only through their
+// `Base` chain: overloads hidden by a subclass, and members of a virtual base
 
-// Forward declaration
-class FooVisitor;
+GENERATE_HAS_MEMBER_FUNCTION(detected);
+GENERATE_HAS_STATIC_MEMBER_FUNCTION(detectedStatic);
 
-// Alias
-using FooVisitorPtr = std::shared_ptr<FooVisitor>;
+// Signature of a const member function, as queried from the detectors
+template<typename Return, typename... Args>
+using ConstSignature = const Return(Args...);
 
-/**
- * @class FooVisitor
- * Concrete implementation of main hierarchy visitor using Foo front-end
- */
-class FooVisitor : public Visitor {
+class DetectedBase {
  public:
-  // Static methods
-  template<typename... Args>
-  static FooVisitorPtr make(Args&&... args) {
-    return FooVisitorPtr(new FooVisitor(std::forward<Args>(args)...));
-  }
+  // Alias
+  using Base = void;
 
-  // Overriden methods
-  void visit(std::shared_ptr<Baz> /* top */) override {
+  // Static methods
+  static int detectedStatic(int value) {
+    return value;
   }
 
-  void visit(std::shared_ptr<BarDerived> top) override {
-    top->targetFoo()->method();
+  // Concrete methods
+  void detected(int /* value */) {
   }
 
-  void visit(std::shared_ptr<BarReusing> top) override {
-    top->targetFoo()->method();
+  void detected(int /* value */) const {
   }
 };
 
-/* CLASS DumpVisitor **********************************************************/
+/* CLASS DetectedHiding *******************************************************/
 
-// Forward declaration
-class DumpVisitor;
-
-// Alias
-using DumpVisitorPtr = std::shared_ptr<DumpVisitor>;
-
-/**
- * @class DumpVisitor
- * Concrete implementation of main hierarchy visitor calling method dump
- */
-class DumpVisitor : public Visitor {
+class DetectedHiding : public DetectedBase {
  public:
+  // Alias
+  using Base = DetectedBase;
+
   // Static methods
-  template<typename... Args>
-  static DumpVisitorPtr make(Args&&... args) {
-    return DumpVisitorPtr(new DumpVisitor(std::forward<Args>(args)...));
+  static int detectedStatic(double value) {
+    return static_cast<int>(value);
   }
 
-  // Overriden methods
-  void visit(std::shared_ptr<Baz> top) override {
-    top->dump();
+  // Concrete methods
+  void detected(double /* value */) {
   }
+};
 
-  void visit(std::shared_ptr<BarDerived> top) override {
-    top->dump();
-  }
+/* CLASS DetectedVirtual ******************************************************/
 
-  void visit(std::shared_ptr<BarReusing> top) override {
-    top->dump();
-  }
+class DetectedVirtual : public virtual DetectedBase {
+ public:
+  // Alias
+  using Base = DetectedBase;
 };
 
 /*
@@ -1537,6 +311,219 @@ int main(int /* argc */, char ** /* argv */) {
 
   /**/ std::cout << std::endl; /*---------------------------------------------*/
 
+  std::cout << "Test SimpleCreatorStrategy with interned words" << std::endl;
+  std::cout << "===============================================" << std::endl;
+
+  auto interning_creator = BarReusing::targetCreator();
+  interning_creator->add_word("to");
+  interning_creator->add_word("be");
+  std::static_pointer_cast<SimpleCreator<Target, BarReusing>>(
+    interning_creator)->interning(true);
+  interning_creator->add_word("or");
+  interning_creator->add_word("not");
+  interning_creator->add_word("to");
+  interning_creator->add_word("be");
+
+  interning_creator->create(creator_tab_tag{})->dump();
+  std::cout << "Words: " << interning_creator->words().size()
+            << ", distinct: " << interning_creator->words().dictionary_size()
+            << ", characters: " << interning_creator->words().characters()
+            << std::endl;
+
+  auto interned_list = interning_creator->word_list();
+  std::cout << "Word list: " << interned_list.size() << " strings, last \""
+            << interned_list.back() << "\"" << std::endl;
+
+  std::size_t converted_characters = 0;
+  for (const std::string &word : interning_creator->words())
+    converted_characters += word.size();
+  std::cout << "Characters of the words as strings: " << converted_characters
+            << std::endl;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test thread-confined WordStore with plain counting"
+            << std::endl;
+  std::cout << "==================================================="
+            << std::endl;
+
+  BasicWordStore<plain_refcount> local_words;
+  local_words.add("local");
+  auto shared_local_words = local_words;
+  std::cout << std::boolalpha;
+  std::cout << "Copy shares words: "
+            << shared_local_words.shares(local_words) << std::endl;
+  shared_local_words.add("words");
+  std::cout << "Copy shares words after insertion: "
+            << shared_local_words.shares(local_words) << std::endl;
+  std::cout << "Words: " << local_words.size() << " and "
+            << shared_local_words.size() << std::endl;
+  std::cout << std::noboolalpha;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test StreamingCreator from a stream and a mapped file"
+            << std::endl;
+  std::cout << "======================================================"
+            << std::endl;
+
+  std::istringstream word_stream("Streamed  words,\tsplit across\nchunks");
+  auto streaming_creator = Baz::targetCreator(
+    StreamSource::make(word_stream, 4), creator_newline_tag{});
+  streaming_creator->create()->dump();
+
+  char mapped_path[] = "/tmp/architecture.words.XXXXXX";
+  ::close(::mkstemp(mapped_path));
+  {
+    auto mapped_file = FileSink::make(mapped_path);
+    const std::string mapped_text = "Mapped words of a file\n";
+    mapped_file->write(Span<char>(mapped_text.data(), mapped_text.size()));
+  }
+  auto mapped_creator = Baz::targetCreator(
+    MappedSource::make(mapped_path), creator_space_tag{});
+  mapped_creator->create()->dump();
+  std::remove(mapped_path);
+
+  std::istringstream pulled_stream("Words pulled chunk by chunk, not kept");
+  auto pulling_creator = StreamingCreator<Target, Baz, creator_space_tag>::make(
+    StreamSource::make(pulled_stream, 8), creator_space_tag{});
+  std::size_t pulled_words = 0;
+  pulling_creator->pull([&pulled_words](Span<char>) { pulled_words++; });
+  std::cout << "Words pulled from the first chunk: " << pulled_words
+            << std::endl;
+  while (pulling_creator->pull([&pulled_words](Span<char>) {
+    pulled_words++;
+  })) {}
+  std::cout << "Words pulled: " << pulled_words << std::endl;
+  try {
+    pulling_creator->create();
+  } catch (const std::logic_error &error) {
+    std::cout << "Created after pulling: " << error.what() << std::endl;
+  }
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test CachedCreator memoization" << std::endl;
+  std::cout << "===============================" << std::endl;
+
+  auto memoizing_creator = CachedCreator<Target, Baz, creator_space_tag>::make(
+    creator_space_tag{});
+  memoizing_creator->memoizing(true);
+  memoizing_creator->add_word("Memoized");
+
+  auto first_memoized = memoizing_creator->create();
+  std::cout << std::boolalpha;
+  std::cout << "Same model when unchanged: "
+            << (memoizing_creator->create() == first_memoized) << std::endl;
+  memoizing_creator->add_word("model");
+  std::cout << "Same model after add_word: "
+            << (memoizing_creator->create() == first_memoized) << std::endl;
+  auto tagged_memoized = memoizing_creator->create(creator_newline_tag{});
+  std::cout << "Same model for the same tag: "
+            << (memoizing_creator->create(creator_newline_tag{})
+                == tagged_memoized) << std::endl;
+  std::cout << "Same model for another tag: "
+            << (memoizing_creator->create(creator_space_tag{})
+                == tagged_memoized) << std::endl;
+
+  std::vector<BazPtr> concurrent_memoized(4);
+  std::vector<std::thread> memoizing_threads;
+  for (unsigned int i = 0; i < concurrent_memoized.size(); i++) {
+    memoizing_threads.emplace_back([&memoizing_creator,
+                                    &concurrent_memoized, i] {
+      concurrent_memoized[i] = memoizing_creator->create(creator_newline_tag{});
+    });
+  }
+  for (auto &memoizing_thread : memoizing_threads) memoizing_thread.join();
+  std::cout << "Same model for concurrent calls: "
+            << (std::count(concurrent_memoized.begin(),
+                           concurrent_memoized.end(), concurrent_memoized[0])
+                == 4) << std::endl;
+
+  std::cout << "Memoizable tag, value and pointers: "
+            << memoizable<creator_space_tag>::value << " "
+            << memoizable<std::string>::value << " "
+            << memoizable<int *>::value << " "
+            << memoizable<std::shared_ptr<int>>::value << std::endl;
+  std::cout << "Same key for equal arguments: "
+            << MemoArgs<std::string>("a").equals(MemoArgs<std::string>("a"))
+            << std::endl;
+  std::cout << "Same key for arguments of another type: "
+            << MemoArgs<int>(1).equals(MemoArgs<long>(1)) << std::endl;
+
+  auto nesting_creator
+    = CachedCreator<Target, BazNesting, creator_newline_tag>::make(
+        creator_newline_tag{});
+  nesting_creator->memoizing(true);
+  nesting_creator->add_word("Nested");
+  nesting_creator->add_word("creation");
+  auto nesting_model = nesting_creator->create();
+  std::cout << "Same model when created again: "
+            << (nesting_creator->create() == nesting_model) << std::endl;
+  std::cout << "Text created reentrantly: " << nesting_model->text()
+            << std::endl;
+
+  memoizing_creator->memoizing(true, 1);
+  auto bounded_memoized = memoizing_creator->create(creator_newline_tag{});
+  memoizing_creator->create(creator_space_tag{});
+  std::cout << "Same model past the capacity: "
+            << (memoizing_creator->create(creator_newline_tag{})
+                == bounded_memoized) << std::endl;
+
+  auto reached_creator = BarDerived::targetCreator(creator_space_tag{});
+  auto reaching_creator = BarDerived::targetCreator(
+    creator_space_tag{},
+    std::vector<CreatorPtr<Target, BarDerived::State>>{ reached_creator });
+  std::vector<std::size_t> word_counts, reached_counts;
+  reaching_creator->count_words(word_counts);
+  reached_creator->add_word("reached");
+  reaching_creator->count_words(reached_counts);
+  std::cout << "Creators counted: " << word_counts.size() << std::endl;
+  std::cout << "Counts changed by a reached creator: "
+            << (word_counts != reached_counts) << std::endl;
+  std::cout << std::noboolalpha;
+  memoizing_creator->create()->dump();
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test StaticCreator strategies" << std::endl;
+  std::cout << "==============================" << std::endl;
+
+  StaticCreator<Target, Baz, simple_strategy> static_simple_creator;
+  static_simple_creator.add_word("Simple");
+  static_simple_creator.add_word("strategy");
+  static_simple_creator.create(creator_newline_tag{})->dump();
+
+  StaticCreator<Target, Baz, cached_strategy<creator_space_tag>>
+    static_cached_creator(creator_space_tag{});
+  static_cached_creator.add_word("Cached");
+  static_cached_creator.add_word("strategy");
+  static_cached_creator.create()->dump();
+  static_cached_creator.creator()->create()->dump();
+
+  StaticCreator<Target, Baz, fixed_strategy> static_fixed_creator(
+    Baz::make("Fixed strategy"));
+  static_fixed_creator.create()->dump();
+  static_fixed_creator.creator()->create()->dump();
+  std::cout << std::boolalpha;
+  std::cout << "Same fixed creator: "
+            << (static_fixed_creator.creator()
+                == static_fixed_creator.creator()) << std::endl;
+  std::cout << std::noboolalpha;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test lazy text shared with the creator" << std::endl;
+  std::cout << "=======================================" << std::endl;
+
+  auto lazy_bar = interning_creator->create(creator_tab_tag{});
+  interning_creator->add_word("!");
+  lazy_bar->dump();
+  interning_creator->create(creator_tab_tag{})->dump();
+  std::cout << "Lazy text size: " << lazy_bar->rope().size() << std::endl;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
   std::cout << "######################" << std::endl;
   std::cout << "# Test Foo front-end #" << std::endl;
   std::cout << "######################" << std::endl;
@@ -1581,6 +568,55 @@ int main(int /* argc */, char ** /* argv */) {
 
   /**/ std::cout << std::endl; /*---------------------------------------------*/
 
+  std::cout << "Test front-end reuse" << std::endl;
+  std::cout << "=====================" << std::endl;
+  auto bar_derived_copy = BarDerived::make(*bar_derived);
+  std::cout << std::boolalpha;
+  std::cout << "Same simple Foo for Target: "
+            << (bar_derived->targetFoo(false) == bar_derived->targetFoo(false))
+            << std::endl;
+  std::cout << "Same cached Foo for Spot: "
+            << (bar_derived->spotFoo(true) == bar_derived->spotFoo(true))
+            << std::endl;
+  std::cout << "Same cached Foo in a copy: "
+            << (bar_derived->targetFoo(true)
+                == bar_derived_copy->targetFoo(true))
+            << std::endl;
+  std::cout << std::noboolalpha;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test borrowed front-end of the exact class" << std::endl;
+  std::cout << "==========================================" << std::endl;
+
+  auto lending = std::make_shared<BarLending>();
+  lending->targetFoo(false)->method("simple call");
+  lending->targetFoo(true)->method("cached call");
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test CachedFoo memoization" << std::endl;
+  std::cout << "===========================" << std::endl;
+  auto memoizing_foo = std::static_pointer_cast<CachedFoo<Target, BarDerived>>(
+    bar_derived->targetFoo(true));
+  memoizing_foo->method("hello");
+  memoizing_foo->method("hello");
+  memoizing_foo->method("world!");
+  std::cout << "Memoized inputs: "
+            << memoizing_foo->cache().size() << std::endl;
+  std::cout << "Weight of 'world!': "
+            << *memoizing_foo->cache().find("world!") << std::endl;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test batched Foo front-end" << std::endl;
+  std::cout << "===========================" << std::endl;
+  std::vector<std::string> batch = { "first", "second" };
+  bar_derived->targetFoo(false)->method(batch);
+  bar_reusing->spotFoo(true)->method(batch);
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
   std::cout << "##########################" << std::endl;
   std::cout << "# Test Visitor front-end #" << std::endl;
   std::cout << "##########################" << std::endl;
@@ -1634,5 +670,528 @@ int main(int /* argc */, char ** /* argv */) {
 
   /**/ std::cout << std::endl; /*---------------------------------------------*/
 
+  std::cout << "Test DumpVisitor with a state overriding accept" << std::endl;
+  std::cout << "==============================================" << std::endl;
+
+  auto announcing_composite = BarDerived::make("Announcing composite",
+    std::vector<BarDerivedPtr>{
+      std::make_shared<BarAnnouncing>("Announcing state")
+    });
+  announcing_composite->acceptor(DumpVisitor::make())->pre_order();
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test DumpVisitor with buffered sinks" << std::endl;
+  std::cout << "=====================================" << std::endl;
+
+  auto buffer_sink = BufferSink::make();
+  composite->acceptor(DumpVisitor::make(buffer_sink))->post_order();
+
+  auto async_buffer_sink = BufferSink::make();
+  auto async_sink = AsyncSink::make(async_buffer_sink, 16);
+  composite->acceptor(DumpVisitor::make(async_sink))->post_order();
+  async_sink->flush();
+
+  std::cout << std::boolalpha;
+  std::cout << "Buffered characters: "
+            << buffer_sink->str().size() << std::endl;
+  std::cout << "Same asynchronous dump: "
+            << (async_buffer_sink->str() == buffer_sink->str()) << std::endl;
+  std::cout << std::noboolalpha;
+
+  std::cout.flush();
+  auto descriptor_sink = DescriptorSink::make(STDOUT_FILENO, 8);
+  composite->dump(*descriptor_sink);
+  descriptor_sink->flush();
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test StaticDumpVisitor in pre-order" << std::endl;
+  std::cout << "===================================" << std::endl;
+
+  TopVariant(composite).accept(StaticDumpVisitor{},
+                               Acceptor::traversal::pre_order);
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test StaticFooVisitor with TopVariant" << std::endl;
+  std::cout << "======================================" << std::endl;
+
+  std::vector<TopVariant> tops = {
+    TopVariant(simple_created_baz_with_space),
+    TopVariant(bar_reusing),
+    TopVariant(bar_derived)
+  };
+
+  for (const auto &top : tops)
+    top.visit(StaticFooVisitor{});
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test FlatComposite in pre-order" << std::endl;
+  std::cout << "===============================" << std::endl;
+
+  auto flat_composite = FlatComposite::compile(*composite);
+  auto dump_flat = [](const FlatComposite::Node& /* node */, Span<char> text) {
+    std::cout.write(text.begin(), text.size()) << std::endl;
+  };
+
+  flat_composite.pre_order(dump_flat);
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test FlatComposite in post-order" << std::endl;
+  std::cout << "================================" << std::endl;
+
+  flat_composite.post_order(dump_flat);
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test CountVisitor in parallel" << std::endl;
+  std::cout << "==============================" << std::endl;
+
+  WorkStealingPool pool(4);
+
+  std::vector<CreatorPtr<Target, BarDerived::State>> wide_state_creators;
+  for (unsigned int i = 0; i < 8; i++) {
+    wide_state_creators.push_back(
+      BarDerived::targetCreator(creator_space_tag{}));
+  }
+
+  auto wide_composite_creator = BarDerived::targetCreator(
+    creator_space_tag{}, wide_state_creators);
+  for (const auto& w : sample_words) {
+    wide_composite_creator->add_word(w);
+  }
+  auto wide_composite = wide_composite_creator->create();
+
+  auto count_visitor = CountVisitor::make();
+  wide_composite->acceptor(count_visitor)->pre_order(pool, 0);
+  composite->acceptor(count_visitor)->post_order(pool, 0);
+  std::cout << "Visited nodes: " << count_visitor->count() << std::endl;
+
+  try {
+    composite->acceptor(DumpVisitor::make())->pre_order(pool);
+  } catch (const std::logic_error &error) {
+    std::cout << "Error: " << error.what() << std::endl;
+  }
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test BarDerived with states created in parallel" << std::endl;
+  std::cout << "================================================" << std::endl;
+
+  auto parallel_composite_creator = BarDerived::targetCreator(
+    creator_space_tag{},
+    std::vector<CreatorPtr<Target, BarDerived::State>>{
+      BarDerived::targetCreator(creator_carriage_tag{}),
+      BarDerived::targetCreator(creator_space_tag{})
+    },
+    parallel_policy{pool}
+  );
+  for (const auto& w : sample_words) {
+    parallel_composite_creator->add_word(w);
+  }
+  auto parallel_composite = parallel_composite_creator->create();
+
+  auto serial_dump = BufferSink::make();
+  auto parallel_dump = BufferSink::make();
+  composite->acceptor(DumpVisitor::make(serial_dump))->pre_order();
+  parallel_composite->acceptor(DumpVisitor::make(parallel_dump))->pre_order();
+
+  std::cout << std::boolalpha;
+  std::cout << "States: " << parallel_composite->states().size() << std::endl;
+  std::cout << "Same dump as in series: "
+            << (parallel_dump->str() == serial_dump->str()) << std::endl;
+  std::cout << std::noboolalpha;
+
+  // Both states share the creator of their own states, so they are created
+  // in series
+  auto shared_state_creator = BarDerived::targetCreator(creator_space_tag{});
+  auto sharing_composite_creator = BarDerived::targetCreator(
+    creator_space_tag{},
+    std::vector<CreatorPtr<Target, BarDerived::State>>{
+      BarDerived::targetCreator(
+        creator_carriage_tag{},
+        std::vector<CreatorPtr<Target, BarDerived::State>>{
+          shared_state_creator
+        }),
+      BarDerived::targetCreator(
+        creator_newline_tag{},
+        std::vector<CreatorPtr<Target, BarDerived::State>>{
+          shared_state_creator
+        })
+    },
+    parallel_policy{pool}
+  );
+  for (const auto& w : sample_words) {
+    sharing_composite_creator->add_word(w);
+  }
+  sharing_composite_creator->create();
+  std::cout << "Words of the shared creator: "
+            << shared_state_creator->words().size() << " of "
+            << sample_words.size() << std::endl;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test ModelImage saved and loaded" << std::endl;
+  std::cout << "================================" << std::endl;
+
+  auto image_buffer = BufferSink::make();
+  ModelImage::save(TopVariant(composite), *image_buffer);
+  auto loaded_composite = ModelImage::load(
+    Span<char>(image_buffer->str().data(), image_buffer->str().size()),
+    image_buffer);
+
+  auto loaded_dump = BufferSink::make();
+  loaded_composite.accept(StaticDumpVisitor(*loaded_dump),
+                          Acceptor::traversal::pre_order);
+
+  std::cout << std::boolalpha;
+  std::cout << "Image size: " << image_buffer->str().size() << std::endl;
+  std::cout << "Same dump as the original: "
+            << (loaded_dump->str() == serial_dump->str()) << std::endl;
+  std::cout << std::noboolalpha;
+
+  char image_path[] = "/tmp/architecture.image.XXXXXX";
+  ::close(::mkstemp(image_path));
+  {
+    auto image_file = FileSink::make(image_path);
+    ModelImage::save(TopVariant(simple_created_baz_with_space), *image_file);
+  }
+  ModelImage::load(image_path).visit(StaticDumpVisitor{});
+  std::remove(image_path);
+
+  try {
+    ModelImage::load(image_path);
+  } catch (const std::system_error &error) {
+    std::cout << "Error: " << error.code().message() << std::endl;
+  }
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test BarDerived allocated in an arena" << std::endl;
+  std::cout << "======================================" << std::endl;
+
+  {
+    auto arena = MonotonicArena::make(4096);
+    ArenaAllocator<char> arena_allocator(arena);
+
+    std::vector<BarDerivedPtr> arena_states = {
+      make_allocated<BarDerived>(arena_allocator, "first state"),
+      BarDerived::make(std::allocator_arg, arena_allocator, "second state")
+    };
+    auto arena_composite = BarDerived::make(
+      std::allocator_arg, arena_allocator, "arena composite", arena_states);
+    auto arena_creator = SimpleCreator<Target, Baz>::make(
+      std::allocator_arg, arena_allocator);
+
+    arena_composite->acceptor(DumpVisitor::make())->pre_order();
+    std::cout << "Arena blocks: " << arena->blocks() << std::endl;
+
+    arena->allocate(1, 1);
+    auto over_aligned = reinterpret_cast<std::uintptr_t>(
+      arena->allocate(64, 64));
+    std::cout << std::boolalpha;
+    std::cout << "Same type as with make: "
+              << (typeid(*arena_composite) == typeid(BarDerived)) << std::endl;
+    std::cout << "Over-aligned allocation: " << (over_aligned % 64 == 0)
+              << std::endl;
+    std::cout << std::noboolalpha;
+
+    std::vector<BarDerivedPtr> arena_chain = {
+      BarDerived::make(std::allocator_arg, arena_allocator, "link")
+    };
+    for (unsigned int i = 0; i < 200000; i++) {
+      arena_chain.push_back(BarDerived::make(
+        std::allocator_arg, arena_allocator, "link",
+        std::vector<BarDerivedPtr>{ arena_chain.back() }));
+    }
+    auto chain_visitor = CountVisitor::make();
+    arena_chain.back()->acceptor(chain_visitor)->post_order();
+    std::cout << "Visited nodes of a deep chain: " << chain_visitor->count()
+              << std::endl;
+    while (!arena_chain.empty()) arena_chain.pop_back();  // Not recursively
+  }
+
+  {
+    auto local_arena = LocalArena::make(4096);
+    ArenaAllocator<char, LocalArena> local_allocator(local_arena);
+
+    auto local_baz = Baz::make(
+      std::allocator_arg, local_allocator, "local arena text");
+    local_baz->dump();
+    std::cout << "Local arena blocks: " << local_arena->blocks() << std::endl;
+  }
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test FixedCreator sharing the predefined model" << std::endl;
+  std::cout << "===============================================" << std::endl;
+
+  auto fixed_creator = BarDerived::targetCreator(composite);
+  auto fixed_model = fixed_creator->create();
+
+  std::cout << std::boolalpha;
+  std::cout << "Distinct model: " << (fixed_model != composite) << std::endl;
+  std::cout << "Shared text: "
+            << fixed_model->rope().shares(composite->rope()) << std::endl;
+  std::cout << "Shared states: "
+            << (fixed_model->states().begin() == composite->states().begin())
+            << std::endl;
+  std::cout << std::noboolalpha;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test CallProfiler merging per-thread counters" << std::endl;
+  std::cout << "==============================================" << std::endl;
+
+  auto &profiler = CallProfiler::instance();
+  auto profiled_site
+    = CallProfiler::site<SimpleFoo<Target, BarDerived>, BarDerived>("profiled");
+
+  for (std::uint64_t nanoseconds : { 0, 100, 1000 })
+    profiler.record(profiled_site, nanoseconds);
+  std::thread profiled_thread([&profiler, profiled_site] {
+    for (int i = 0; i < 3; i++) profiler.record(profiled_site, 5000);
+  });
+  profiled_thread.join();
+
+  auto profiled = profiler.snapshot()[profiled_site];
+  std::cout << profiled.front_end << " -> " << profiled.model
+            << "::" << profiled.method << std::endl;
+  std::cout << "Calls: " << profiled.calls << std::endl;
+  std::cout << "Mean: " << profiled.mean() << " ns" << std::endl;
+  std::cout << "p50: " << profiled.percentile(0.5) << " ns" << std::endl;
+  std::cout << "p99: " << profiled.percentile(0.99) << " ns" << std::endl;
+  for (std::size_t i = 0; i < profiled.histogram.size(); i++) {
+    if (profiled.histogram[i] == 0) continue;
+    std::cout << "Bucket " << i << ": " << profiled.histogram[i] << std::endl;
+  }
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test Tracer recording creation and traversal" << std::endl;
+  std::cout << "=============================================" << std::endl;
+
+  Tracer::instance().clear();
+  Tracer::enable();
+  auto traced_composite = composite_creator->create();
+  traced_composite->acceptor(CountVisitor::make())->post_order();
+  Tracer::enable(false);
+  composite->acceptor(CountVisitor::make())->post_order();
+
+  auto trace_events = Tracer::instance().events();
+  for (const auto &event : trace_events)
+    std::cout << event.name << std::endl;
+
+  auto trace_dump = BufferSink::make();
+  Tracer::instance().dump(*trace_dump);
+  std::string trace_json = trace_dump->str();
+
+  std::cout << std::boolalpha;
+  std::cout << "Chrome trace: "
+            << (trace_json.compare(0, 16, "{\"traceEvents\":[") == 0)
+            << std::endl;
+  std::size_t complete_events = 0;
+  for (auto i = trace_json.find("\"ph\":\"X\""); i != std::string::npos;
+       i = trace_json.find("\"ph\":\"X\"", i + 1))
+    complete_events++;
+  std::cout << "Complete events: " << complete_events << std::endl;
+  std::cout << std::noboolalpha;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test ConcurrentMemoTable shared by threads" << std::endl;
+  std::cout << "==========================================" << std::endl;
+
+  BarDerived::Cache shared_cache;
+  std::atomic<unsigned int> computed_weights(0);
+
+  std::vector<std::thread> cache_readers;
+  for (unsigned int t = 0; t < 4; t++) {
+    cache_readers.emplace_back([&shared_cache, &computed_weights,
+                                &sample_words] {
+      for (unsigned int round = 0; round < 100; round++) {
+        for (const auto &w : sample_words) {
+          shared_cache.get(w + w, [&computed_weights, &w] {
+            computed_weights++;
+            return 2.0 * w.size();
+          });
+        }
+      }
+    });
+  }
+  for (auto &cache_reader : cache_readers) cache_reader.join();
+
+  BarDerived::Cache copied_cache = shared_cache;
+
+  std::cout << "Entries: " << shared_cache.size() << std::endl;
+  std::cout << std::boolalpha;
+  std::cout << "Every entry computed: "
+            << (computed_weights >= shared_cache.size()) << std::endl;
+  std::cout << std::noboolalpha;
+  std::cout << "Weight of 'zz': " << *shared_cache.find("zz") << std::endl;
+  std::cout << "Copied entries: " << copied_cache.size() << std::endl;
+
+  ConcurrentMemoTable<std::string, double, std::hash<std::string>, 1>
+    nested_cache;
+  double nested_weight = nested_cache.get("outer", [&nested_cache] {
+    return nested_cache.get("inner", [] { return 1.0; }) + 1.0;
+  });
+  std::cout << "Weight computed from the same shard: " << nested_weight
+            << std::endl;
+
+  BarDerived::Cache bounded_cache(2);
+  for (const auto &w : { "a", "b", "c" })
+    bounded_cache.get(w, [] { return 1.0; });
+  std::cout << "Entries kept under a capacity of 2: " << bounded_cache.size()
+            << std::endl;
+  std::cout << "Weight past the capacity: "
+            << bounded_cache.get("d", [] { return 3.0; }) << std::endl;
+  bounded_cache.clear();
+  std::cout << "Entries after clear: " << bounded_cache.size() << std::endl;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test AsyncFoo coalescing calls into batches" << std::endl;
+  std::cout << "============================================" << std::endl;
+
+  {
+    WorkStealingPool async_pool(1);
+    BatchingExecutor executor(async_pool);
+    AsyncFoo<Target> async_foo(bar_derived->targetFoo(false), executor);
+    AsyncFoo<Target> other_async_foo(
+      std::make_shared<SimpleFoo<Target, BarDerived>>(bar_derived), executor);
+    AsyncFoo<Target> cached_async_foo(bar_derived->targetFoo(true), executor);
+
+    // The only worker is kept busy while the calls are made
+    std::promise<void> busy, release;
+    std::shared_future<void> released = release.get_future().share();
+    async_pool.submit([&busy, released] {
+      busy.set_value();
+      released.wait();
+    });
+    busy.get_future().wait();
+
+    std::vector<std::future<void>> async_calls;
+    for (const auto &msg : { "first", "second" })
+      async_calls.push_back(async_foo.method(msg));
+    async_calls.push_back(other_async_foo.method("third"));
+    async_calls.push_back(cached_async_foo.method("fourth"));
+    release.set_value();
+
+    for (auto &async_call : async_calls) async_call.get();
+    std::cout << "Batches: " << executor.batches() << std::endl;
+  }
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test front-end handles sharing the model ownership"
+            << std::endl;
+  std::cout << "==================================================="
+            << std::endl;
+
+  auto owning_model = BarDerived::make("Owning model");
+  auto owned_foo = std::static_pointer_cast<CachedFoo<Target, BarDerived>>(
+    owning_model->targetFoo(true));
+  auto delegated_foo = shared_handle(owned_foo.get());
+  std::weak_ptr<BarDerived> released_model = owning_model;
+  owning_model = nullptr;
+  owned_foo = nullptr;
+
+  std::cout << std::boolalpha;
+  std::cout << "Model alive through the handle: "
+            << !released_model.expired() << std::endl;
+  delegated_foo = nullptr;
+  std::cout << "Model released with the handle: "
+            << released_model.expired() << std::endl;
+  std::cout << std::noboolalpha;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test intrusive handles of models and front-ends" << std::endl;
+  std::cout << "================================================" << std::endl;
+
+  auto counting_model = BarCounting<atomic_refcount>::make();
+  auto counting_handle = counting_model->handle();
+  auto counting_acceptor = counting_model->acceptor(CountVisitor::make());
+  std::cout << "Handle count: " << counting_handle.use_count() << std::endl;
+  counting_model = nullptr;
+  counting_acceptor = nullptr;
+  std::cout << "Count after the owner: " << counting_handle.use_count()
+            << std::endl;
+  counting_handle->targetFoo(false)->method("through an outliving handle");
+
+  auto allocated_counting = make_allocated<BarCounting<atomic_refcount>>(
+    std::allocator<char>());
+  auto allocated_handle = allocated_counting->handle();
+  allocated_counting = nullptr;
+  std::cout << "Allocated model count after the owner: "
+            << allocated_handle.use_count() << std::endl;
+  allocated_handle->targetFoo(false)->method("through an allocated handle");
+
+  using CountingHandles = BarCounting<atomic_refcount>::Handles;
+  auto owned_counting
+    = CountingHandles::make<BarCounting<atomic_refcount>>();
+  auto counting_foo = owned_counting->targetFoo(false);
+  auto counting_foo_handle = delegation_handle(
+    static_cast<SimpleFoo<Target, BarCounting<atomic_refcount>> *>(
+      counting_foo.get()));
+  owned_counting = nullptr;
+  counting_foo = nullptr;
+
+  std::cout << "Model counted by the front-end handle: "
+            << counting_foo_handle.use_count() << std::endl;
+  counting_foo_handle->method("through a kept handle");
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test intrusive handles counted without atomics" << std::endl;
+  std::cout << "===============================================" << std::endl;
+
+  auto plain_model = BarCounting<plain_refcount>::make();
+  auto plain_handle = plain_model->handle();
+  auto plain_acceptor = plain_model->acceptor(CountVisitor::make());
+  std::cout << "Handle count: " << plain_handle.use_count() << std::endl;
+  auto plain_foo = plain_model->targetFoo(true);
+  plain_model = nullptr;
+  plain_acceptor = nullptr;
+  std::cout << "Count after the owner: " << plain_handle.use_count()
+            << std::endl;
+  plain_foo->method("through a plain handle");
+  std::cout << "Messages in the plain cache: "
+            << std::static_pointer_cast<
+                 CachedFoo<Target, BarCounting<plain_refcount>>>(plain_foo)
+                 ->cache().size() << std::endl;
+  plain_foo = nullptr;
+  std::cout << "Count after the front-end: " << plain_handle.use_count()
+            << std::endl;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
+  std::cout << "Test member detectors walking the Base chain" << std::endl;
+  std::cout << "============================================" << std::endl;
+
+  std::cout << std::boolalpha;
+  std::cout << "Overload hidden by a subclass: "
+            << has_member_function_detected<
+                 DetectedHiding, void(int)>::value << std::endl;
+  std::cout << "Const overload hidden by a subclass: "
+            << has_member_function_detected<
+                 DetectedHiding, ConstSignature<void, int>>::value << std::endl;
+  std::cout << "Static overload hidden by a subclass: "
+            << has_static_member_function_detectedStatic<
+                 DetectedHiding, int(int)>::value << std::endl;
+  std::cout << "Member of a virtual base: "
+            << has_member_function_detected<
+                 DetectedVirtual, void(int)>::value << std::endl;
+  std::cout << "Missing overload: "
+            << has_member_function_detected<
+                 DetectedVirtual, void(double)>::value << std::endl;
+  std::cout << std::noboolalpha;
+
+  /**/ std::cout << std::endl; /*---------------------------------------------*/
+
   return 0;
 }
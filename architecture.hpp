@@ -0,0 +1,6144 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//                            foo = model->foo()                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//                             foo->method(msg)                               //
+//                                    \/                                      //
+//                           foo->method(tag, msg)                            //
+//                                    \/                                      //
+//                          model->method(foo, msg)                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ARCHITECTURE_HPP_
+#define ARCHITECTURE_HPP_
+
+// Standard headers
+#include <new>
+#include <deque>
+#include <mutex>
+#include <tuple>
+#include <cmath>
+#include <atomic>
+#include <future>
+#include <cerrno>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <typeinfo>
+#include <typeindex>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <type_traits>
+#include <system_error>
+#include <unordered_map>
+#include <condition_variable>
+
+// ABI headers
+#include <cxxabi.h>
+
+// POSIX headers
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                 MEMBER DETECTER
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+// These macro are aimed to create a member detector: a class and type trait
+// that can be used to check if a type/member function/static member function
+// exists in a class. As there is an infinite number of names, it's impossible
+// to create a type trait only with the resources the language provides. Given
+// that, it's necessary to create a macro to automatically generate all classes
+// and alias from a name given as parameter.
+
+// The following macros create:
+// - Template classes that uses SFINAE to decide if the member exists in the
+//   class or in one of its superclasses. Member functions are detected by
+//   converting `&_Klass::member` to a pointer to member of `_Klass` itself,
+//   which also accepts inherited members: a single instantiation per query
+//   found this way. Only when it fails (an overload hidden by a subclass, a
+//   member of a virtual base, or no member at all) the `Base` chain is
+//   walked, one instantiation per level, as the detectors always did.
+// - A struct inheriting from `std::integral_constant`, which have a trait
+//   compliant with STL.
+// - Two alias `has_##member_tag` and `no_##member_tag` to selectively create
+//   member functions by applying SFINAE on its parameters.
+
+/*============================================================================*/
+/*                                BASE OF CLASS                               */
+/*============================================================================*/
+
+// `Base` alias of a class, or void if it has none (ending the `Base` chain)
+
+template<typename T>
+struct void_of { using type = void; };
+
+template<typename T, typename = void>
+struct base_of { using type = void; };
+
+template<typename T>
+struct base_of<T, typename void_of<typename T::Base>::type> {
+  using type = typename T::Base;
+};
+
+template<typename T>
+using base_of_t = typename base_of<T>::type;
+
+/*============================================================================*/
+/*                            MEMBER TYPE DETECTOR                            */
+/*============================================================================*/
+
+#define GENERATE_HAS_MEMBER_TYPE(member)                                       \
+                                                                               \
+/*- TYPE DETECTOR ----------------------------------------------------------*/ \
+                                                                               \
+template<typename _Klass, typename _Type>                                      \
+class HasType_##member                                                         \
+{                                                                              \
+ private:                                                                      \
+  template<typename _U> static std::true_type test(typename _U::_Type*);       \
+  template<typename _U> static std::false_type test(...);                      \
+                                                                               \
+ public:                                                                       \
+  static constexpr bool value = decltype(test<_Klass>(nullptr))::value         \
+    || HasType_##member<typename _Klass::Base, _Type>::value;                  \
+};                                                                             \
+                                                                               \
+/*- TAGS -------------------------------------------------------------------*/ \
+                                                                               \
+struct no_##member##_tag {};                                                   \
+struct has_##member##_tag {};                                                  \
+                                                                               \
+/*- TYPE TRAIT -------------------------------------------------------------*/ \
+                                                                               \
+template<typename _Klass, typename _Type>                                      \
+struct has_type_##member                                                       \
+    : public std::integral_constant<                                           \
+               bool, HasType_##member<_Klass, _Type>::value> {                 \
+  using tag = typename std::conditional<                                       \
+                has_type_##member<_Klass, _Type>::value,                       \
+                has_##member##_tag, no_##member##_tag                          \
+              >::type;                                                         \
+}
+
+/*============================================================================*/
+/*                          MEMBER FUNCTION DETECTOR                          */
+/*============================================================================*/
+
+#define GENERATE_HAS_MEMBER_FUNCTION(member)                                   \
+                                                                               \
+template<typename _Klass, typename Dummy>                                      \
+class HasMemberFunction_##member;                                              \
+                                                                               \
+/*- NON-CONST MEMBER FUNCTION ----------------------------------------------*/ \
+                                                                               \
+template<typename _Return, typename... _Args>                                  \
+class HasMemberFunction_##member<void, _Return(_Args...)> {                    \
+ public:                                                                       \
+  static constexpr bool value = false;                                         \
+};                                                                             \
+                                                                               \
+template<typename _Klass, typename _Return, typename... _Args>                 \
+class HasMemberFunction_##member<_Klass, _Return(_Args...)>                    \
+{                                                                              \
+ private:                                                                      \
+  template<typename _U>                                                        \
+  static std::true_type test(                                                  \
+    decltype(static_cast<_Return(_U::*)(_Args...)>(&_U::member))*);            \
+                                                                               \
+  template<typename _U>                                                        \
+  static HasMemberFunction_##member<base_of_t<_U>, _Return(_Args...)>          \
+  test(...);                                                                   \
+                                                                               \
+ public:                                                                       \
+  static constexpr bool value = decltype(test<_Klass>(nullptr))::value;        \
+};                                                                             \
+                                                                               \
+/*- CONST MEMBER FUNCTION --------------------------------------------------*/ \
+                                                                               \
+template<typename _Return, typename... _Args>                                  \
+class HasMemberFunction_##member<void, const _Return(_Args...)> {              \
+ public:                                                                       \
+  static constexpr bool value = false;                                         \
+};                                                                             \
+                                                                               \
+template<typename _Klass, typename _Return, typename... _Args>                 \
+class HasMemberFunction_##member<_Klass, const _Return(_Args...)>              \
+{                                                                              \
+ private:                                                                      \
+  template<typename _U>                                                        \
+  static std::true_type test(                                                  \
+    decltype(static_cast<_Return(_U::*)(_Args...) const>(&_U::member))*);      \
+                                                                               \
+  template<typename _U>                                                        \
+  static HasMemberFunction_##member<base_of_t<_U>, const _Return(_Args...)>    \
+  test(...);                                                                   \
+                                                                               \
+ public:                                                                       \
+  static constexpr bool value = decltype(test<_Klass>(nullptr))::value;        \
+};                                                                             \
+                                                                               \
+/*- TAGS -------------------------------------------------------------------*/ \
+                                                                               \
+struct no_##member##_tag {};                                                   \
+struct has_##member##_tag {};                                                  \
+                                                                               \
+/*- TYPE TRAIT -------------------------------------------------------------*/ \
+                                                                               \
+template<typename _Klass, typename Dummy>                                      \
+struct has_member_function_##member;                                           \
+                                                                               \
+template<typename _Klass, typename _Return, typename... _Args>                 \
+struct has_member_function_##member<_Klass, _Return(_Args...)>                 \
+    : public std::integral_constant<bool, HasMemberFunction_##member<          \
+                                            _Klass, _Return(_Args...)          \
+                                          >::value> {                          \
+                                                                               \
+  using tag = typename std::conditional<                                       \
+                has_member_function_##member<                                  \
+                  _Klass, _Return(_Args...)                                    \
+                >::value,                                                      \
+                has_##member##_tag, no_##member##_tag                          \
+              >::type;                                                         \
+}
+
+/*============================================================================*/
+/*                      STATIC MEMBER FUNCTION DETECTOR                       */
+/*============================================================================*/
+
+#define GENERATE_HAS_STATIC_MEMBER_FUNCTION(member)                            \
+                                                                               \
+template<typename _Klass, typename Dummy>                                      \
+class HasStaticMemberFunction_##member;                                        \
+                                                                               \
+/*- STATIC MEMBER FUNCTION -------------------------------------------------*/ \
+                                                                               \
+template<typename _Return, typename... _Args>                                  \
+class HasStaticMemberFunction_##member<void, _Return(_Args...)> {              \
+ public:                                                                       \
+  static constexpr bool value = false;                                         \
+};                                                                             \
+                                                                               \
+template<typename _Klass, typename _Return, typename... _Args>                 \
+class HasStaticMemberFunction_##member<_Klass, _Return(_Args...)>              \
+{                                                                              \
+ private:                                                                      \
+  template<typename _U>                                                        \
+  static std::true_type test(                                                  \
+    decltype(static_cast<_Return(*)(_Args...)>(&_U::member))*);                \
+                                                                               \
+  template<typename _U>                                                        \
+  static HasStaticMemberFunction_##member<base_of_t<_U>, _Return(_Args...)>    \
+  test(...);                                                                   \
+                                                                               \
+ public:                                                                       \
+  static constexpr bool value = decltype(test<_Klass>(nullptr))::value;        \
+};                                                                             \
+                                                                               \
+/*- TAGS -------------------------------------------------------------------*/ \
+                                                                               \
+struct no_##member##_tag {};                                                   \
+struct has_##member##_tag {};                                                  \
+                                                                               \
+/*- TYPE TRAIT -------------------------------------------------------------*/ \
+                                                                               \
+template<typename _Klass, typename Dummy>                                      \
+struct has_static_member_function_##member;                                    \
+                                                                               \
+template<typename _Klass, typename _Return, typename... _Args>                 \
+struct has_static_member_function_##member<_Klass, _Return(_Args...)>          \
+    : public std::integral_constant<bool, HasStaticMemberFunction_##member<    \
+                                            _Klass, _Return(_Args...)          \
+                                          >::value> {                          \
+                                                                               \
+  using tag = typename std::conditional<                                       \
+                has_static_member_function_##member<                           \
+                  _Klass, _Return(_Args...)                                    \
+                >::value,                                                      \
+                has_##member##_tag, no_##member##_tag                          \
+              >::type;                                                         \
+}
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                MEMBER DELEGATOR
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+// Thase macros are aimed to avoid replication of code when creating new member
+// functions for a given front-end. They require almost no knowledge about the
+// front end class, but  that the front-end superclass -end inherits from
+// std::enable_shared_from_this (or that the front-end gives handles of its
+// own `Handles` policy, see shared_handles).
+
+// If the delegated class has an overload receiving the front-end by const
+// reference, it is preferred over the one receiving a std::shared_ptr. This
+// way, models can opt-in a borrowed mode that does not touch the reference
+// counter of the front-end (the caller keeps it alive during the call), as
+// the models of the hierarchy do for their Foo and Creator front-ends.
+// Only overloads taking the exact class of the front-end are borrowing, so
+// the ones of a superclass do not hide the shared ones of its subclasses.
+
+/*============================================================================*/
+/*                           LATE EVALUATED BOOLEANS                          */
+/*============================================================================*/
+
+template<typename T>
+struct always_true : public std::integral_constant<bool, true> {};
+
+template<typename T>
+struct always_false : public std::integral_constant<bool, false> {};
+
+/*============================================================================*/
+/*                              NON CONST RETURN                              */
+/*============================================================================*/
+
+template <typename T> struct non_const_return { typedef T type; };
+
+template <typename T> struct non_const_return<T const  > { typedef T   type; };
+template <typename T> struct non_const_return<T const& > { typedef T&  type; };
+template <typename T> struct non_const_return<T const* > { typedef T*  type; };
+template <typename T> struct non_const_return<T const&&> { typedef T&& type; };
+
+template <typename T>
+using non_const_return_t = typename non_const_return<T>::type;
+
+template<typename T>
+non_const_return_t<T> non_const_cast(T t) {
+    return (non_const_return_t<T>) t;
+}
+
+/*============================================================================*/
+/*                              CLASS OF POINTER                              */
+/*============================================================================*/
+
+template<typename T> struct class_of;
+
+template<typename T> struct class_of<T*> {
+  using type = typename std::remove_cv<
+    typename std::remove_pointer<T*>::type>::type;
+};
+
+template<typename T>
+using class_of_t = typename class_of<T>::type;
+
+/*============================================================================*/
+/*                          FIRST PARAMETER INJECTION                         */
+/*============================================================================*/
+
+template<typename Ptr, typename Dummy> struct inject_first_parameter;
+
+template<typename Ptr, typename Klass, typename Result, typename... Args>
+struct inject_first_parameter<Ptr, Result(Klass::*)(Args...)> {
+  using type = Result(Ptr, Args...);
+};
+
+template<typename Ptr, typename Klass, typename Result, typename... Args>
+struct inject_first_parameter<Ptr, Result(Klass::*)(Args...) const> {
+  using type = const Result(Ptr, Args...);
+};
+
+/*============================================================================*/
+/*                              CONTAINER UNPACK                              */
+/*============================================================================*/
+
+template<typename Func, template<typename...> class Pack,
+         typename Ptr, typename... Args, std::size_t... I>
+auto call_helper(const Func &func, const Ptr &ptr, const Pack<Args...> &params,
+                   std::index_sequence<I...>) {
+  return func(ptr, std::get<I>(params)...);
+}
+
+template<typename Func, template<typename...> class Pack,
+         typename Ptr, typename... Args>
+auto call(const Func &func, const Ptr &ptr, const Pack<Args...> &params) {
+  return call_helper(func, ptr, params, std::index_sequence_for<Args...>{});
+}
+
+/*============================================================================*/
+/*                             DELEGATION PRIORITY                            */
+/*============================================================================*/
+
+struct delegate_shared_tag {};
+struct delegate_borrowed_tag : public delegate_shared_tag {};
+
+/*============================================================================*/
+/*                              BORROWED FRONT-END                            */
+/*============================================================================*/
+
+// Front-end given to borrowing overloads, converting only to a const
+// reference of its exact class (not of its superclasses)
+
+template<typename T>
+class Borrowed {
+ public:
+  explicit Borrowed(const T &object) : _object(object) {
+  }
+
+  template<typename U,
+           typename = std::enable_if_t<std::is_same<U, T>::value>>
+  operator const U &() const {
+    return _object;
+  }
+
+ private:
+  const T &_object;
+};
+
+template<typename T>
+Borrowed<T> borrow(const T *object) {
+  return Borrowed<T>(*object);
+}
+
+/*============================================================================*/
+/*                                SHARED HANDLE                               */
+/*============================================================================*/
+
+// Handle given to models when delegating with shared ownership. Objects
+// owned by their model (with a non-empty `owner()`, see LazyFrontEnd) share
+// the ownership of the model instead, so handles kept by the model's
+// methods cannot outlive it.
+
+template<typename T>
+auto shared_handle(T *object, int)
+    -> decltype(object->owner().lock(), std::shared_ptr<T>()) {
+  if (auto owner = object->owner().lock())
+    return std::shared_ptr<T>(owner, object);
+  return std::static_pointer_cast<T>(object->shared_from_this());
+}
+
+template<typename T>
+std::shared_ptr<T> shared_handle(T *object, long) {
+  return std::static_pointer_cast<T>(object->shared_from_this());
+}
+
+template<typename T>
+std::shared_ptr<T> shared_handle(T *object) {
+  return shared_handle(object, 0);
+}
+
+// Front-ends with a handle policy (`Handles`, see shared_handles) give the
+// handles of that policy instead
+
+template<typename T>
+auto delegation_handle(T *object, int)
+    -> decltype(T::Handles::from(object)) {
+  return T::Handles::from(object);
+}
+
+template<typename T>
+std::shared_ptr<T> delegation_handle(T *object, long) {
+  return shared_handle(object);
+}
+
+template<typename T>
+auto delegation_handle(T *object) -> decltype(delegation_handle(object, 0)) {
+  return delegation_handle(object, 0);
+}
+
+/*============================================================================*/
+/*                            DELEGATOR PROFILING                             */
+/*============================================================================*/
+
+// When ARCHITECTURE_PROFILE is defined, each call made through a delegator is
+// counted and timed by the CallProfiler, per front-end, model and method.
+// Otherwise, the hook expands to nothing.
+
+#ifdef ARCHITECTURE_PROFILE
+#define PROFILE_DELEGATOR_CALL(method, model)                                  \
+  static const std::size_t method##Site                                        \
+    = CallProfiler::site<class_of_t<decltype(this)>, model>(#method);          \
+  CallTimer method##Timer(method##Site)
+#else
+#define PROFILE_DELEGATOR_CALL(method, model)                                  \
+do {} while (false)
+#endif
+
+/*============================================================================*/
+/*                    MEMBER FUNCTION DELEGATOR GENERATION                    */
+/*============================================================================*/
+
+#define GENERATE_MEMBER_FUNCTION_DELEGATOR(method, delegatedObject)            \
+                                                                               \
+template<typename... Args>                                                     \
+inline auto method##Delegate(delegate_borrowed_tag, Args&&... args) const      \
+    -> decltype((this->delegatedObject)->method(                               \
+                  borrow(this), std::forward<Args>(args)...)) {                \
+  return (this->delegatedObject)->method(                                      \
+    borrow(this), std::forward<Args>(args)...);                                \
+}                                                                              \
+                                                                               \
+template<typename... Args>                                                     \
+inline auto method##Delegate(delegate_shared_tag, Args&&... args) const        \
+    -> decltype((this->delegatedObject)->method(                               \
+                  delegation_handle(                                           \
+                    const_cast<class_of_t<decltype(this)>*>(this)),            \
+                  std::forward<Args>(args)...)) {                              \
+  return (this->delegatedObject)->method(                                      \
+    delegation_handle(const_cast<class_of_t<decltype(this)>*>(this)),          \
+    std::forward<Args>(args)...);                                              \
+}                                                                              \
+                                                                               \
+template<typename... Args>                                                     \
+inline auto method##Impl(Args&&... args) const                                 \
+    -> decltype(non_const_cast(this)->method(std::forward<Args>(args)...)) {   \
+  PROFILE_DELEGATOR_CALL(method,                                               \
+                         std::decay_t<decltype(*(this->delegatedObject))>);    \
+  return method##Delegate(delegate_borrowed_tag{},                             \
+                          std::forward<Args>(args)...);                        \
+}                                                                              \
+                                                                               \
+template<typename... Args>                                                     \
+inline auto method##Impl(Args&&... args)                                       \
+    -> decltype(this->method(std::forward<Args>(args)...)) {                   \
+  return (non_const_return_t<decltype(this->method(args...))>) (               \
+    static_cast<const class_of_t<decltype(this)> *>(this)->method##Impl(       \
+      std::forward<Args>(args)...));                                           \
+}
+
+/*============================================================================*/
+/*                       MEMBER FUNCTION DELEGATOR CALL                       */
+/*============================================================================*/
+
+#define CALL_MEMBER_FUNCTION_DELEGATOR(method, ...)                            \
+do { return method##Impl(__VA_ARGS__); } while (false)
+
+/*============================================================================*/
+/*                STATIC MEMBER FUNCTION DELEGATOR GENERATION                 */
+/*============================================================================*/
+
+#define GENERATE_STATIC_MEMBER_FUNCTION_DELEGATOR(method, delegatedClass)      \
+                                                                               \
+GENERATE_HAS_STATIC_MEMBER_FUNCTION(delegate);                                 \
+GENERATE_HAS_STATIC_MEMBER_FUNCTION(method##Alt);                              \
+                                                                               \
+template<typename... Args>                                                     \
+inline auto method##Delegate(delegate_borrowed_tag, Args&&... args) const      \
+    -> decltype(delegatedClass::method(                                        \
+                  borrow(this), std::forward<Args>(args)...)) {                \
+  return delegatedClass::method(borrow(this), std::forward<Args>(args)...);    \
+}                                                                              \
+                                                                               \
+template<typename... Args>                                                     \
+inline auto method##Delegate(delegate_shared_tag, Args&&... args) const        \
+    -> decltype(delegatedClass::method(                                        \
+                  std::static_pointer_cast<class_of_t<decltype(this)>>(        \
+                    non_const_cast(this)->shared_from_this()),                 \
+                  std::forward<Args>(args)...)) {                              \
+  return delegatedClass::method(                                               \
+    std::static_pointer_cast<class_of_t<decltype(this)>>(                      \
+      const_cast<class_of_t<decltype(this)>*>(this)->shared_from_this()),      \
+    std::forward<Args>(args)...);                                              \
+}                                                                              \
+                                                                               \
+template<typename... Args>                                                     \
+inline auto method##Impl(Args&&... args) const                                 \
+    -> decltype(non_const_cast(this)->method(std::forward<Args>(args)...)) {   \
+  PROFILE_DELEGATOR_CALL(method, delegatedClass);                              \
+  if (delegate()) {                                                            \
+    return method##Delegate(delegate_borrowed_tag{},                           \
+                            std::forward<Args>(args)...);                      \
+  }                                                                            \
+  return method##Alt();                                                        \
+}                                                                              \
+                                                                               \
+template<typename... Args>                                                     \
+inline auto method##Impl(Args&&... args)                                       \
+    -> decltype(this->method(std::forward<Args>(args)...)) {                   \
+  return (non_const_return_t<                                                  \
+            decltype(this->method(std::forward<Args>(args)...))>) (            \
+    static_cast<const class_of_t<decltype(this)> *>(this)->method##Impl(       \
+      std::forward<Args>(args)...));                                           \
+}                                                                              \
+                                                                               \
+inline auto method##Impl() const                                               \
+    -> decltype(non_const_cast(this)->method()) {                              \
+  PROFILE_DELEGATOR_CALL(method, delegatedClass);                              \
+  return method##Alt();                                                        \
+}                                                                              \
+                                                                               \
+inline auto method##Impl()                                                     \
+    -> decltype(this->method()) {                                              \
+  return (non_const_return_t<decltype(this->method())>) (                      \
+    static_cast<const class_of_t<decltype(this)>*>(this)->method##Impl());     \
+}                                                                              \
+                                                                               \
+template<typename _T = void>                                                   \
+inline constexpr auto method##Alt(_T* = nullptr) const                         \
+    -> decltype(typename std::enable_if<                                       \
+                  !has_static_member_function_##method##Alt<                   \
+                    class_of_t<decltype(this)>, void()                         \
+                  >::value                                                     \
+                >::type(),                                                     \
+                non_const_cast(this)->method()) {                              \
+  throw std::logic_error("Cannot call '" #method "' without parameters");      \
+}                                                                              \
+                                                                               \
+template<typename _T = void>                                                   \
+inline constexpr auto method##Alt(_T* = nullptr)                               \
+    -> decltype(typename std::enable_if<                                       \
+                  !has_static_member_function_##method##Alt<                   \
+                    class_of_t<decltype(this)>, void()                         \
+                  >::value                                                     \
+                >::type(),                                                     \
+                non_const_cast(this)->method()) {                              \
+  return (non_const_return_t<decltype(this->method())>) (                      \
+    static_cast<const class_of_t<decltype(this)>*>(this)->method##Impl());     \
+}                                                                              \
+                                                                               \
+template<typename _T = void>                                                   \
+inline constexpr auto delegate(_T* = nullptr) const                            \
+    -> decltype(typename std::enable_if<                                       \
+                  !has_static_member_function_delegate<                        \
+                    class_of_t<decltype(this)>, void()                         \
+                  >::value                                                     \
+                >::type(), bool()) {                                           \
+  return true;                                                                 \
+}                                                                              \
+                                                                               \
+template<typename _T = void>                                                   \
+inline constexpr auto delegate(_T* = nullptr)                                  \
+    -> decltype(typename std::enable_if<                                       \
+                  !has_static_member_function_delegate<                        \
+                    class_of_t<decltype(this)>, void()                         \
+                  >::value                                                     \
+                >::type(), bool()) {                                           \
+  return (non_const_return_t<decltype(this->method())>) (                      \
+    static_cast<const class_of_t<decltype(this)>*>(this)->method##Impl());     \
+}
+
+/*============================================================================*/
+/*                   STATIC MEMBER FUNCTION DELEGATOR CALL                    */
+/*============================================================================*/
+
+#define CALL_STATIC_MEMBER_FUNCTION_DELEGATOR(method, ...)                     \
+do { return method##Impl(__VA_ARGS__); } while (false)
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                 COMMON CLASSES
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* CLASS Target ***************************************************************/
+
+class Target {
+};
+
+/* CLASS Spot *****************************************************************/
+
+class Spot {
+};
+
+/* CLASS Span *****************************************************************/
+
+/**
+ * @class Span
+ * Non-owning, read-only view of a contiguous sequence of elements. Spans of
+ * characters (the words of a WordStore) convert to std::string
+ */
+template<typename T>
+class Span {
+ public:
+  // Alias
+  using value_type = T;
+  using iterator = const T*;
+
+  // Constructors
+  Span() = default;
+
+  Span(const T *data, std::size_t size)
+      : _data(data), _size(size) {
+  }
+
+  template<typename Allocator>
+  Span(const std::vector<T, Allocator> &elements)
+      : _data(elements.data()), _size(elements.size()) {
+  }
+
+  // Operators
+  const T &operator[](std::size_t i) const {
+    return _data[i];
+  }
+
+  // Concrete methods
+  iterator begin() const {
+    return _data;
+  }
+
+  iterator end() const {
+    return _data + _size;
+  }
+
+  std::size_t size() const {
+    return _size;
+  }
+
+  bool empty() const {
+    return _size == 0;
+  }
+
+  template<typename U = T,
+           typename = std::enable_if_t<std::is_same<U, char>::value>>
+  operator std::string() const {
+    return std::string(_data, _size);
+  }
+
+ private:
+  // Instance variables
+  const T *_data = nullptr;
+  std::size_t _size = 0;
+};
+
+/* STRUCT atomic_refcount *****************************************************/
+
+// Policies of reference counting for RefCounted: atomic for objects shared
+// among threads, plain (cheaper) for objects confined to a single thread
+
+struct atomic_refcount {
+  using count_type = std::atomic<std::size_t>;
+  using thread_safe = std::true_type;
+
+  static void increment(count_type &count) {
+    count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static bool decrement(count_type &count) {
+    return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  static std::size_t load(const count_type &count) {
+    return count.load(std::memory_order_acquire);
+  }
+};
+
+struct plain_refcount {
+  using count_type = std::size_t;
+  using thread_safe = std::false_type;
+
+  static void increment(count_type &count) {
+    count++;
+  }
+
+  static bool decrement(count_type &count) {
+    return --count == 0;
+  }
+
+  static std::size_t load(const count_type &count) {
+    return count;
+  }
+};
+
+/* CLASS RefCounted ***********************************************************/
+
+// Forward declaration
+template<typename T>
+class IntrusivePtr;
+
+/**
+ * @class RefCounted
+ * Base of objects holding their own reference count, handled by
+ * IntrusivePtr with a single allocation and no weak count. Copies of an
+ * object start with no references
+ */
+template<typename Policy>
+class RefCounted {
+ public:
+  // Alias
+  using refcount_policy = Policy;
+
+  // Concrete methods
+  std::size_t use_count() const {
+    return Policy::load(_count);
+  }
+
+ protected:
+  // Constructors
+  RefCounted() : _count(0) {
+  }
+
+  explicit RefCounted(std::size_t count) : _count(count) {
+  }
+
+  RefCounted(const RefCounted &) : _count(0) {
+  }
+
+  // Destructor
+  ~RefCounted() = default;
+
+  // Operators
+  RefCounted &operator=(const RefCounted &) {
+    return *this;
+  }
+
+  // Static methods
+  // Destroys an object once its last reference is released (hidden by
+  // subclasses not built by new)
+  template<typename T>
+  static void dispose(T *object) {
+    delete object;
+  }
+
+ private:
+  // Instance variables
+  mutable typename Policy::count_type _count;
+
+  // Friends
+  template<typename T>
+  friend class IntrusivePtr;
+};
+
+/* CLASS IntrusivePtr *********************************************************/
+
+/**
+ * @class IntrusivePtr
+ * Owning handle of a RefCounted object, counting with the policy of its
+ * class
+ */
+template<typename T>
+class IntrusivePtr {
+ public:
+  // Constructors
+  IntrusivePtr() = default;
+
+  // Takes a reference already held on the object if add_ref is false
+  explicit IntrusivePtr(T *pointer, bool add_ref = true)
+      : _pointer(pointer) {
+    if (add_ref) retain();
+  }
+
+  IntrusivePtr(const IntrusivePtr &other)
+      : _pointer(other._pointer) {
+    retain();
+  }
+
+  IntrusivePtr(IntrusivePtr &&other) noexcept
+      : _pointer(other._pointer) {
+    other._pointer = nullptr;
+  }
+
+  // Destructor
+  ~IntrusivePtr() {
+    release();
+  }
+
+  // Operators
+  IntrusivePtr &operator=(IntrusivePtr other) noexcept {
+    std::swap(_pointer, other._pointer);
+    return *this;
+  }
+
+  T &operator*() const {
+    return *_pointer;
+  }
+
+  T *operator->() const {
+    return _pointer;
+  }
+
+  explicit operator bool() const {
+    return _pointer != nullptr;
+  }
+
+  bool operator==(const IntrusivePtr &other) const {
+    return _pointer == other._pointer;
+  }
+
+  bool operator!=(const IntrusivePtr &other) const {
+    return _pointer != other._pointer;
+  }
+
+  // Concrete methods
+  T *get() const {
+    return _pointer;
+  }
+
+  std::size_t use_count() const {
+    return _pointer ? _pointer->use_count() : 0;
+  }
+
+  // Gives away the reference held, without releasing it
+  T *detach() {
+    T *pointer = _pointer;
+    _pointer = nullptr;
+    return pointer;
+  }
+
+ private:
+  // Instance variables
+  T *_pointer = nullptr;
+
+  // Concrete methods
+  // (T may still be incomplete where the handle type is only named)
+  void retain() {
+    using Policy = typename T::refcount_policy;
+    if (_pointer) Policy::increment(_pointer->_count);
+  }
+
+  void release() {
+    using Policy = typename T::refcount_policy;
+    T *pointer = detach();
+    if (pointer && Policy::decrement(pointer->_count)) T::dispose(pointer);
+  }
+};
+
+/* FUNCTION make_intrusive ****************************************************/
+
+template<typename T, typename... Args>
+IntrusivePtr<T> make_intrusive(Args&&... args) {
+  return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+/* STRUCT allocated_access ****************************************************/
+
+// Classes of the hierarchy have protected constructors, which make_allocated
+// and the handle policies reach through this struct (befriended by them).
+// Objects are built as themselves, so their dynamic type is the same as when
+// built by `make`
+struct allocated_access {
+  template<typename T, typename... Args>
+  static void construct(T *pointer, Args&&... args) {
+    ::new (static_cast<void *>(pointer)) T(std::forward<Args>(args)...);
+  }
+
+  template<typename T, typename... Args>
+  static T *create(Args&&... args) {
+    return new T(std::forward<Args>(args)...);
+  }
+};
+
+/* STRUCT shared_handles ******************************************************/
+
+// Policies of the handles given to models of the Top hierarchy (and taken by
+// their front-ends) when traversing and delegating: std::shared_ptr, or
+// handles counting intrusively with the given policy. Objects counted
+// intrusively are owned only through `make` or `own` (a std::shared_ptr
+// holding the reference they start with, or taking over the one of an
+// object built with an allocator), and are given as a std::shared_ptr (by
+// `share`) only to cross the interfaces taking it. Both kinds of handles
+// of an object owned by a model (see LazyFrontEnd) keep the model alive
+// instead. Models whose handles are not thread-safe are confined to a single
+// thread, and so are their caches (see TopCrtp)
+
+struct shared_handles {
+  using thread_safe = std::true_type;
+
+  template<typename T>
+  using handle = std::shared_ptr<T>;
+
+  template<typename T>
+  using shareable = std::enable_shared_from_this<T>;
+
+  struct counted {};
+
+  template<typename T>
+  static std::shared_ptr<T> own(T *object) {
+    return std::shared_ptr<T>(object);
+  }
+
+  template<typename T>
+  static std::shared_ptr<T> own(std::shared_ptr<T> object) {
+    return object;
+  }
+
+  template<typename T, typename... Args>
+  static std::shared_ptr<T> make(Args&&... args) {
+    return std::make_shared<T>(std::forward<Args>(args)...);
+  }
+
+  template<typename T>
+  static handle<T> from(T *object) {
+    return shared_handle(object);
+  }
+
+  template<typename T>
+  static std::shared_ptr<T> share(T *object) {
+    return shared_handle(object);
+  }
+
+  // Owners are reached through `owner()` (see shared_handle)
+  template<typename T, typename M>
+  static void anchor(T &/* object */, M &/* model */) {
+  }
+};
+
+template<typename RefCount>
+struct intrusive_handles {
+  using thread_safe = typename RefCount::thread_safe;
+
+  template<typename T>
+  struct shareable {};
+
+  /**
+   * @class counted
+   * Base of objects counted intrusively. They start with one reference,
+   * released only by the std::shared_ptr given by own(), and handles are
+   * taken only from owned objects (or objects anchored to an owned model),
+   * so a handle always owns what it points to
+   */
+  class counted : public RefCounted<RefCount> {
+   public:
+    // Destructor
+    virtual ~counted() = default;
+
+    // Concrete methods
+    counted *anchor() const {
+      return _anchor ? _anchor : const_cast<counted *>(this);
+    }
+
+    void anchor(counted *model) {
+      _anchor = model;
+    }
+
+    bool owned() const {
+      return anchor()->_owned;
+    }
+
+   protected:
+    // Constructors
+    counted() : RefCounted<RefCount>(1) {
+    }
+
+    counted(const counted &) : RefCounted<RefCount>(1) {
+    }
+
+    // Operators
+    counted &operator=(const counted &) {
+      return *this;
+    }
+
+   private:
+    // Instance variables
+    counted *_anchor = nullptr;
+    bool _owned = false;
+    std::shared_ptr<const void> _storage;  // Of objects built by allocators
+
+    // Static methods
+    static void dispose(counted *object) {
+      if (!object->_storage) {
+        delete object;
+        return;
+      }
+      // Destroyed and deallocated with the storage, on return
+      std::shared_ptr<const void> storage = std::move(object->_storage);
+    }
+
+    // Friends
+    friend struct intrusive_handles;
+
+    template<typename T>
+    friend class IntrusivePtr;
+  };
+
+  /**
+   * @class handle
+   * Handle of an object counted intrusively, holding a reference of its
+   * anchor (the object itself, or the model owning it)
+   */
+  template<typename T>
+  class handle {
+   public:
+    // Constructors
+    handle() = default;
+
+    explicit handle(T *pointer)
+        : _pointer(pointer),
+          _anchor(pointer ? pointer->anchor() : nullptr) {
+    }
+
+    // Operators
+    T &operator*() const {
+      return *_pointer;
+    }
+
+    T *operator->() const {
+      return _pointer;
+    }
+
+    explicit operator bool() const {
+      return _pointer != nullptr;
+    }
+
+    bool operator==(const handle &other) const {
+      return _pointer == other._pointer;
+    }
+
+    bool operator!=(const handle &other) const {
+      return _pointer != other._pointer;
+    }
+
+    // Concrete methods
+    T *get() const {
+      return _pointer;
+    }
+
+    std::size_t use_count() const {
+      return _anchor.use_count();
+    }
+
+   private:
+    // Instance variables
+    T *_pointer = nullptr;
+    IntrusivePtr<counted> _anchor;
+  };
+
+  template<typename T>
+  static std::shared_ptr<T> own(T *object) {
+    if (object->_owned)
+      throw std::logic_error("Cannot own an object counted twice");
+    object->_owned = true;
+    return std::shared_ptr<T>(object, [](T *pointer) {
+      IntrusivePtr<counted> reference(pointer, false);  // Released on return
+    });
+  }
+
+  // Objects built with an allocator (see make_allocated) keep their storage
+  // until their last reference is released, not their last owner
+  template<typename T>
+  static std::shared_ptr<T> own(std::shared_ptr<T> object) {
+    T *pointer = object.get();
+    if (pointer->_owned)
+      throw std::logic_error("Cannot own an object counted twice");
+    pointer->_storage = std::move(object);
+    return own(pointer);
+  }
+
+  template<typename T, typename... Args>
+  static std::shared_ptr<T> make(Args&&... args) {
+    return own(allocated_access::create<T>(std::forward<Args>(args)...));
+  }
+
+  template<typename T>
+  static handle<T> from(T *object) {
+    if (!object->owned())
+      throw std::logic_error("Cannot handle an object not built by make");
+    return handle<T>(object);
+  }
+
+  // The std::shared_ptr holds a reference of the anchor until its last owner
+  // is gone (not until its last weak reference is). It takes a control block
+  // of its own, so the interfaces taking a std::shared_ptr (Visitor, and the
+  // FooPtr, AcceptorPtr and CreatorPtr returned to callers) still count
+  // atomically: only the handles of this policy avoid it
+  template<typename T>
+  static std::shared_ptr<T> share(T *object) {
+    if (!object->owned())
+      throw std::logic_error("Cannot handle an object not built by make");
+    counted *anchor = IntrusivePtr<counted>(object->anchor()).detach();
+    return std::shared_ptr<T>(object, [anchor](T *) {
+      IntrusivePtr<counted> reference(anchor, false);  // Released on return
+    });
+  }
+
+  template<typename T, typename M>
+  static void anchor(T &object, M &model) {
+    object.anchor(&model);
+  }
+};
+
+/* CLASS BasicWordStore *******************************************************/
+
+/**
+ * @class BasicWordStore
+ * Sequence of words stored in a single contiguous arena of characters, each
+ * word being an (offset, size) entry of a dictionary. When interning, equal
+ * words share the same entry (and id). Copies share the arena, which is only
+ * duplicated by the first insertion in a shared store (copy-on-write), and
+ * count their references with the given policy. That insertion copies the
+ * whole arena (characters, entries, sequence and interning table), so copies
+ * cost as much as their store once written: a store still growing should be
+ * copied only when filled. Spans returned are valid only until the next
+ * insertion. Ids are 32-bit, so adding a word past
+ * 2^32 - 1 entries (one per word, or per distinct word when interning)
+ * throws std::length_error.
+ */
+template<typename RefCount = atomic_refcount>
+class BasicWordStore {
+ public:
+  // Alias
+  using Id = std::uint32_t;
+
+  // Inner classes
+  class const_iterator {
+   public:
+    // Alias
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Span<char>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Span<char>*;
+    using reference = Span<char>;
+
+    // Constructors
+    const_iterator(const BasicWordStore *store, std::size_t i)
+        : _store(store), _i(i) {
+    }
+
+    Span<char> operator*() const {
+      return (*_store)[_i];
+    }
+
+    const_iterator &operator++() {
+      _i++;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      _i++;
+      return previous;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return _i == other._i;
+    }
+
+    bool operator!=(const const_iterator &other) const {
+      return _i != other._i;
+    }
+
+   private:
+    const BasicWordStore *_store;
+    std::size_t _i;
+  };
+
+  // Constructors
+  explicit BasicWordStore(bool interning = false)
+      : _data(interning ? make_intrusive<Data>(true) : blank()) {
+  }
+
+  // Operators
+  Span<char> operator[](std::size_t i) const {
+    return text(_data->sequence[i]);
+  }
+
+  // Concrete methods
+  Id add(Span<char> word) {
+    detach();
+    Id id = _data->interning ? intern(word) : insert(word);
+    _data->sequence.push_back(id);
+    return id;
+  }
+
+  Id add(const std::string &word) {
+    return add(Span<char>(word.data(), word.size()));
+  }
+
+  Id id(std::size_t i) const {
+    return _data->sequence[i];
+  }
+
+  Span<char> text(Id id) const {
+    const Entry &entry = _data->entries[id];
+    return Span<char>(_data->chars.data() + entry.offset, entry.size);
+  }
+
+  Span<char> back() const {
+    return (*this)[size() - 1];
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, size());
+  }
+
+  std::size_t size() const {
+    return _data->sequence.size();
+  }
+
+  bool empty() const {
+    return _data->sequence.empty();
+  }
+
+  std::size_t dictionary_size() const {
+    return _data->entries.size();
+  }
+
+  std::size_t characters() const {
+    return _data->chars.size();
+  }
+
+  bool interning() const {
+    return _data->interning;
+  }
+
+  void interning(bool enabled) {
+    if (enabled == _data->interning) return;
+
+    BasicWordStore store(enabled);
+    store.detach();
+    store._data->chars.reserve(characters());
+    for (const auto &word : *this) store.add(word);
+    *this = std::move(store);
+  }
+
+  bool shares(const BasicWordStore &other) const {
+    return _data == other._data;
+  }
+
+ private:
+  // Inner structs
+  struct Entry {
+    std::size_t offset;
+    std::size_t size;
+  };
+
+  struct Data : public RefCounted<RefCount> {
+    explicit Data(bool enabled) : interning(enabled) {
+    }
+
+    bool interning;
+    std::string chars;
+    std::vector<Entry> entries;
+    std::vector<Id> sequence;
+    std::vector<Id> table;  // Open addressing of (id + 1), 0 when empty
+  };
+
+  // Instance variables
+  IntrusivePtr<Data> _data;
+
+  // Static methods
+  static const IntrusivePtr<Data> &blank() {
+    return blank(typename RefCount::thread_safe{});
+  }
+
+  static const IntrusivePtr<Data> &blank(std::true_type) {
+    static const IntrusivePtr<Data> data = make_intrusive<Data>(false);
+    return data;
+  }
+
+  static const IntrusivePtr<Data> &blank(std::false_type) {
+    // One per thread, as a plain count cannot be shared among threads
+    static thread_local const IntrusivePtr<Data> data
+      = make_intrusive<Data>(false);
+    return data;
+  }
+
+  static std::size_t hash(Span<char> word) {
+    std::size_t value = 14695981039346656037ull;  // FNV-1a
+    for (char c : word) {
+      value ^= static_cast<unsigned char>(c);
+      value *= 1099511628211ull;
+    }
+    return value;
+  }
+
+  // Concrete methods
+  void detach() {
+    if (_data.use_count() > 1) _data = make_intrusive<Data>(*_data);
+  }
+
+  // Ids of interned entries are stored plus one, so the largest Id is
+  // never given to an entry
+  Id insert(Span<char> word) {
+    if (_data->entries.size() >= static_cast<Id>(-1))
+      throw std::length_error("Too many entries for a word store");
+    _data->entries.push_back({ _data->chars.size(), word.size() });
+    _data->chars.append(word.begin(), word.size());
+    return static_cast<Id>(_data->entries.size() - 1);
+  }
+
+  Id intern(Span<char> word) {
+    std::vector<Id> &table = _data->table;
+    if (2 * (_data->entries.size() + 1) > table.size()) {
+      table.assign(std::max<std::size_t>(16, 2 * table.size()), 0);
+      for (Id id = 0; id < _data->entries.size(); id++)
+        table[probe(text(id))] = id + 1;
+    }
+
+    Id &slot = table[probe(word)];
+    if (slot == 0) slot = insert(word) + 1;
+    return slot - 1;
+  }
+
+  std::size_t probe(Span<char> word) const {
+    const std::vector<Id> &table = _data->table;
+    std::size_t mask = table.size() - 1;
+    std::size_t i = hash(word) & mask;
+    while (table[i] != 0) {
+      Span<char> other = text(table[i] - 1);
+      if (other.size() == word.size()
+          && std::equal(word.begin(), word.end(), other.begin()))
+        break;
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+};
+
+// Alias
+using WordStore = BasicWordStore<>;
+
+/* CLASS WordRope *************************************************************/
+
+/**
+ * @class WordRope
+ * Lazy text made of the words of a (shared, copy-on-write) WordStore joined
+ * by a divisor, or viewing a text kept alive by its owner. Its segments can
+ * be visited in order without building the text, which is flattened into a
+ * single string only once, on first request. Texts never change, so copies
+ * share a const representation and nothing is ever copied on write.
+ */
+class WordRope {
+ public:
+  // Constructors
+  WordRope() : _rep(blank()) {
+  }
+
+  WordRope(const char *text) : WordRope(std::string(text)) {
+  }
+
+  WordRope(std::string text) {
+    auto rep = std::make_shared<Rep>();
+    rep->flat = std::move(text);
+    rep->flattened = true;
+    _rep = std::move(rep);
+  }
+
+  WordRope(WordStore words, std::string divisor) {
+    auto rep = std::make_shared<Rep>();
+    rep->words = std::move(words);
+    rep->divisor = std::move(divisor);
+    _rep = std::move(rep);
+  }
+
+  WordRope(Span<char> view, std::shared_ptr<const void> owner) {
+    auto rep = std::make_shared<Rep>();
+    rep->view = view;
+    rep->owner = std::move(owner);
+    _rep = std::move(rep);
+  }
+
+  // Allocator-extended versions, taking the rope (and a text given by the
+  // caller, copied there) from the allocator
+  template<typename Alloc>
+  WordRope(std::allocator_arg_t, const Alloc &/* alloc */,
+           const WordRope &other)
+      : _rep(other._rep) {
+  }
+
+  template<typename Alloc>
+  WordRope(std::allocator_arg_t, const Alloc &alloc, const char *text)
+      : WordRope(std::allocator_arg, alloc,
+                 Span<char>(text, std::strlen(text))) {
+  }
+
+  template<typename Alloc>
+  WordRope(std::allocator_arg_t, const Alloc &alloc, const std::string &text)
+      : WordRope(std::allocator_arg, alloc,
+                 Span<char>(text.data(), text.size())) {
+  }
+
+  template<typename Alloc>
+  WordRope(std::allocator_arg_t, const Alloc &alloc, Span<char> text) {
+    using Text = std::basic_string<
+      char, std::char_traits<char>,
+      typename std::allocator_traits<Alloc>::template rebind_alloc<char>>;
+    auto copy = std::allocate_shared<const Text>(
+      alloc, text.begin(), text.size(), alloc);
+    auto rep = std::allocate_shared<Rep>(alloc);
+    rep->view = Span<char>(copy->data(), copy->size());
+    rep->owner = std::move(copy);
+    _rep = std::move(rep);
+  }
+
+  template<typename Alloc>
+  WordRope(std::allocator_arg_t, const Alloc &alloc,
+           WordStore words, std::string divisor) {
+    auto rep = std::allocate_shared<Rep>(alloc);
+    rep->words = std::move(words);
+    rep->divisor = std::move(divisor);
+    _rep = std::move(rep);
+  }
+
+  // Concrete methods
+  std::size_t size() const {
+    const Rep &rep = *_rep;
+    if (rep.flattened) return rep.flat.size();
+    if (rep.owner) return rep.view.size();
+    if (rep.words.empty()) return 0;
+
+    // Without interning, the arena holds exactly the characters of the words
+    std::size_t characters
+      = rep.words.interning() ? words_size() : rep.words.characters();
+    return characters + rep.divisor.size() * (rep.words.size() - 1);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  template<typename Function>
+  void segments(Function function) const {
+    const Rep &rep = *_rep;
+    if (rep.flattened) {
+      function(Span<char>(rep.flat.data(), rep.flat.size()));
+      return;
+    }
+
+    if (rep.owner) {
+      function(rep.view);
+      return;
+    }
+
+    Span<char> divisor(rep.divisor.data(), rep.divisor.size());
+    for (std::size_t i = 0; i < rep.words.size(); i++) {
+      if (i > 0 && !divisor.empty()) function(divisor);
+      function(rep.words[i]);
+    }
+  }
+
+  const std::string &str() const {
+    const Rep &rep = *_rep;
+    if (!rep.flattened) {
+      std::lock_guard<std::mutex> lock(rep.mutex);
+      if (!rep.flattened) {
+        std::string flat;
+        flat.reserve(size());
+        segments([&flat](Span<char> segment) {
+          flat.append(segment.begin(), segment.size());
+        });
+        rep.flat = std::move(flat);
+        rep.flattened = true;
+      }
+    }
+    return rep.flat;
+  }
+
+  bool shares(const WordRope &other) const {
+    return _rep == other._rep;
+  }
+
+ private:
+  // Inner structs
+  struct Rep {
+    WordStore words;
+    std::string divisor;
+
+    Span<char> view;
+    std::shared_ptr<const void> owner;
+
+    // Text flattened on first request, the only part built after sharing
+    mutable std::mutex mutex;
+    mutable std::atomic<bool> flattened { false };
+    mutable std::string flat;
+  };
+
+  // Instance variables
+  std::shared_ptr<const Rep> _rep;  // Immutable, shared by copies
+
+  // Static methods
+  static const std::shared_ptr<const Rep> &blank() {
+    static const std::shared_ptr<const Rep> rep = [] {
+      auto empty = std::make_shared<Rep>();
+      empty->flattened = true;
+      return empty;
+    }();
+    return rep;
+  }
+
+  // Concrete methods
+  std::size_t words_size() const {
+    std::size_t size = 0;
+    for (const auto &word : _rep->words) size += word.size();
+    return size;
+  }
+};
+
+/* CLASS LazyFrontEnd *********************************************************/
+
+/**
+ * @class LazyFrontEnd
+ * Front-end owned by a model, created only in its first (thread-safe) use,
+ * with the handle policy of the front-end.
+ * Handles given away share the ownership of the model, so the front-end
+ * itself keeps only a non-owning pointer to it (avoiding cycles), plus a
+ * weak one to hand the model's ownership when delegating (see
+ * `shared_handle`). Copies of a model do not share front-ends with the
+ * original.
+ */
+template<typename F>
+class LazyFrontEnd {
+ public:
+  // Alias
+  using FPtr = std::shared_ptr<F>;
+
+  // Constructors
+  LazyFrontEnd() = default;
+
+  LazyFrontEnd(const LazyFrontEnd &/* other */) {
+  }
+
+  // Operators
+  LazyFrontEnd &operator=(const LazyFrontEnd &/* other */) {
+    return *this;
+  }
+
+  // Concrete methods
+  template<typename M>
+  FPtr get(const std::shared_ptr<M> &m) {
+    std::call_once(_flag, [this, &m] {
+      _f = F::Handles::template make<F>(
+        std::shared_ptr<M>(std::shared_ptr<M>(), m.get()));
+      _f->owner(m);
+      F::Handles::anchor(*_f, *m);
+    });
+    return FPtr(m, _f.get());
+  }
+
+ private:
+  // Instance variables
+  std::once_flag _flag;
+  FPtr _f;
+};
+
+/* CLASS MemoTable ************************************************************/
+
+/**
+ * @class MemoTable
+ * Open-addressing hash table (linear probing) memoizing the value computed
+ * for each input of a method. Not thread-safe: the Cache of models (and of
+ * their CachedFoo front-ends) whose handles are confined to a single thread,
+ * such as the ones counted with plain_refcount (see TopCrtp). At most
+ * `capacity` values are kept: past it, the table starts over.
+ * References returned by get() are valid only until the next insertion.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class MemoTable {
+ public:
+  // Alias
+  using key_type = Key;
+  using mapped_type = Value;
+
+  // Constructors
+  explicit MemoTable(std::size_t capacity = 1 << 16)
+      : _capacity(std::max<std::size_t>(capacity, 1)) {
+  }
+
+  // Concrete methods
+  template<typename Compute>
+  const Value &get(const Key &key, Compute compute) {
+    std::size_t hash = Hash{}(key);
+
+    if (!_slots.empty()) {
+      Slot &slot = _slots[probe(key, hash)];
+      if (slot.used) return slot.value;
+    }
+
+    if (_size >= _capacity) clear();
+    if (2 * (_size + 1) > _slots.size())
+      rehash(std::max<std::size_t>(16, 2 * _slots.size()));
+
+    Slot &slot = _slots[probe(key, hash)];
+    slot.value = compute();
+    slot.key = key;
+    slot.hash = hash;
+    slot.used = true;
+    _size++;
+
+    return slot.value;
+  }
+
+  const Value *find(const Key &key) const {
+    if (_slots.empty()) return nullptr;
+    const Slot &slot = _slots[probe(key, Hash{}(key))];
+    return slot.used ? &slot.value : nullptr;
+  }
+
+  std::size_t size() const {
+    return _size;
+  }
+
+  void clear() {
+    _slots.clear();
+    _size = 0;
+  }
+
+ private:
+  // Inner structs
+  struct Slot {
+    bool used = false;
+    std::size_t hash = 0;
+    Key key{};
+    Value value{};
+  };
+
+  // Instance variables
+  std::vector<Slot> _slots;
+  std::size_t _size = 0;
+  std::size_t _capacity;
+
+  // Concrete methods
+  std::size_t probe(const Key &key, std::size_t hash) const {
+    std::size_t mask = _slots.size() - 1;
+    std::size_t i = hash & mask;
+    while (_slots[i].used && !(_slots[i].hash == hash && _slots[i].key == key))
+      i = (i + 1) & mask;
+    return i;
+  }
+
+  void rehash(std::size_t capacity) {
+    std::vector<Slot> old(capacity);
+    std::swap(old, _slots);
+    for (auto &slot : old)
+      if (slot.used) _slots[probe(slot.key, slot.hash)] = std::move(slot);
+  }
+};
+
+/* CLASS ConcurrentMemoTable **************************************************/
+
+/**
+ * @class ConcurrentMemoTable
+ * Memo table safe to share between threads. Keys are spread over shards,
+ * each one an open-addressing table of pointers to immutable entries:
+ * lookups only load those pointers, while insertions lock their shard.
+ * Missing values are computed unlocked (so compute may use the table), and
+ * when threads compute the same key at once, only the first value stored is
+ * kept. About `capacity` values are kept: past it, missing values are
+ * computed but not stored, as entries cannot be freed while lookups may be
+ * reading them. Only clear() frees them (and the tables replaced when
+ * growing), so it must not run while other threads use the table.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>,
+         std::size_t Shards = 16>
+class ConcurrentMemoTable {
+ public:
+  // Alias
+  using key_type = Key;
+  using mapped_type = Value;
+
+  // Constructors
+  explicit ConcurrentMemoTable(std::size_t capacity = 1 << 16)
+      : _capacity(std::max<std::size_t>(capacity, 1)) {
+  }
+
+  ConcurrentMemoTable(const ConcurrentMemoTable &other)
+      : _capacity(other._capacity) {
+    for (const Shard &shard : other._shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (const auto &entry : shard.entries)
+        get(entry->key, [&entry] { return entry->value; });
+    }
+  }
+
+  ConcurrentMemoTable &operator=(const ConcurrentMemoTable &) = delete;
+
+  // Concrete methods
+  template<typename Compute>
+  Value get(const Key &key, Compute compute) {
+    std::size_t hash = Hash{}(key);
+    Shard &shard = _shards[hash % Shards];
+
+    if (const Entry *entry = find(shard, key, hash)) return entry->value;
+
+    std::unique_ptr<Entry> computed(new Entry{ hash, key, compute() });
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (const Entry *entry = find(shard, key, hash)) return entry->value;
+    if (size() >= _capacity) return computed->value;
+
+    const Table *table = shard.table.load(std::memory_order_relaxed);
+    if (!table || 2 * (shard.entries.size() + 1) > table->size())
+      table = rehash(shard, std::max<std::size_t>(
+        16, 2 * (table ? table->size() : 0)));
+
+    shard.entries.push_back(std::move(computed));
+    const Entry *entry = shard.entries.back().get();
+    table->slots[probe(*table, key, hash)].store(
+      entry, std::memory_order_release);
+    shard.size.store(shard.entries.size(), std::memory_order_relaxed);
+
+    return entry->value;
+  }
+
+  const Value *find(const Key &key) const {
+    std::size_t hash = Hash{}(key);
+    const Entry *entry = find(_shards[hash % Shards], key, hash);
+    return entry ? &entry->value : nullptr;
+  }
+
+  std::size_t size() const {
+    std::size_t total = 0;
+    for (const Shard &shard : _shards)
+      total += shard.size.load(std::memory_order_relaxed);
+    return total;
+  }
+
+  void clear() {
+    for (Shard &shard : _shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.table.store(nullptr, std::memory_order_relaxed);
+      shard.size.store(0, std::memory_order_relaxed);
+      shard.entries.clear();
+      shard.tables.clear();
+    }
+  }
+
+ private:
+  // Inner structs
+  struct Entry {
+    std::size_t hash;
+    Key key;
+    Value value;
+  };
+
+  struct Table {
+    std::size_t mask;
+    std::unique_ptr<std::atomic<const Entry*>[]> slots;
+
+    explicit Table(std::size_t capacity)
+        : mask(capacity - 1),
+          slots(new std::atomic<const Entry*>[capacity]) {
+      for (std::size_t i = 0; i < capacity; i++)
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    std::size_t size() const {
+      return mask + 1;
+    }
+  };
+
+  struct Shard {
+    // Read by lookups, on a cache line of its own (padded on both sides,
+    // as `new` ignores over-alignment before C++17)
+    char front_padding[64];
+    std::atomic<const Table*> table{nullptr};
+    char back_padding[64];
+
+    // Written under the mutex; replaced tables are kept until clear(), as
+    // lookups may still be probing them (together, they are smaller than
+    // the current one)
+    mutable std::mutex mutex;
+    std::atomic<std::size_t> size{0};
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::vector<std::unique_ptr<Table>> tables;
+  };
+
+  // Instance variables
+  Shard _shards[Shards];
+  std::size_t _capacity;
+
+  // Static methods
+  static const Entry *find(const Shard &shard, const Key &key,
+                           std::size_t hash) {
+    const Table *table = shard.table.load(std::memory_order_acquire);
+    if (!table) return nullptr;
+
+    std::size_t i = (hash / Shards) & table->mask;
+    for (const Entry *entry = table->slots[i].load(std::memory_order_acquire);
+         entry; entry = table->slots[i].load(std::memory_order_acquire)) {
+      if (entry->hash == hash && entry->key == key) return entry;
+      i = (i + 1) & table->mask;
+    }
+    return nullptr;
+  }
+
+  // Only called with the shard locked, when slots cannot change
+
+  static std::size_t probe(const Table &table, const Key &key,
+                           std::size_t hash) {
+    std::size_t i = (hash / Shards) & table.mask;
+    for (const Entry *entry = table.slots[i].load(std::memory_order_relaxed);
+         entry && !(entry->hash == hash && entry->key == key);
+         entry = table.slots[i].load(std::memory_order_relaxed))
+      i = (i + 1) & table.mask;
+    return i;
+  }
+
+  static const Table *rehash(Shard &shard, std::size_t capacity) {
+    std::unique_ptr<Table> replacement(new Table(capacity));
+    shard.tables.push_back(std::move(replacement));
+    const Table *table = shard.tables.back().get();
+    for (const auto &entry : shard.entries) {
+      table->slots[probe(*table, entry->key, entry->hash)].store(
+        entry.get(), std::memory_order_relaxed);
+    }
+    shard.table.store(table, std::memory_order_release);
+    return table;
+  }
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                  MEMORY ARENA
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+// Models and front-ends may be built by `make_allocated` with an allocator,
+// in place of their `make`, or by the `make(std::allocator_arg, alloc, ...)`
+// overloads, which also take the text and states of models from it. Object
+// and reference count then share a single allocation which, with an
+// ArenaAllocator, is carved out of the blocks of a MonotonicArena (in place
+// of std::pmr, not available in C++14).
+
+/* STRUCT null_mutex **********************************************************/
+
+// Mutex doing nothing, for objects confined to a single thread (see
+// plain_refcount)
+
+struct null_mutex {
+  void lock() {
+  }
+
+  void unlock() {
+  }
+};
+
+/* CLASS BasicMonotonicArena **************************************************/
+
+/**
+ * @class BasicMonotonicArena
+ * Memory resource handing out memory from blocks of growing size, which are
+ * only released all together, when the arena is destroyed. Allocations are
+ * serialized by the given mutex and handles counted with the given policy
+ * (MonotonicArena), or neither locked nor counted atomically for arenas
+ * confined to a single thread (LocalArena). Blocks may be backed by
+ * (transparent) huge pages
+ */
+template<typename Mutex, typename RefCount>
+class BasicMonotonicArena : public RefCounted<RefCount> {
+ public:
+  // Alias
+  using Self = BasicMonotonicArena;
+  using SelfPtr = IntrusivePtr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return make_intrusive<Self>(std::forward<Args>(args)...);
+  }
+
+  // Constructors
+  explicit BasicMonotonicArena(std::size_t block_size = 1 << 16,
+                               bool huge_pages = false)
+      : _block_size(std::max<std::size_t>(block_size, 64)),
+        _huge_pages(huge_pages) {
+  }
+
+  BasicMonotonicArena(const BasicMonotonicArena &) = delete;
+  BasicMonotonicArena &operator=(const BasicMonotonicArena &) = delete;
+
+  // Destructor
+  ~BasicMonotonicArena() {
+    for (const auto &block : _blocks) {
+      if (_huge_pages)
+        ::munmap(block.first, block.second);
+      else
+        ::operator delete(block.first);
+    }
+  }
+
+  // Concrete methods
+  void *allocate(std::size_t size, std::size_t alignment) {
+    std::lock_guard<Mutex> lock(_mutex);
+
+    std::size_t offset = aligned(alignment);
+    if (_blocks.empty() || offset + size > _blocks.back().second) {
+      grow(size + alignment);
+      offset = aligned(alignment);
+    }
+
+    _offset = offset + size;
+    _allocated += size;
+    return static_cast<char *>(_blocks.back().first) + offset;
+  }
+
+  void deallocate(void * /* pointer */, std::size_t /* size */) {
+  }
+
+  std::size_t blocks() const {
+    std::lock_guard<Mutex> lock(_mutex);
+    return _blocks.size();
+  }
+
+  std::size_t allocated() const {
+    std::lock_guard<Mutex> lock(_mutex);
+    return _allocated;
+  }
+
+ private:
+  // Instance variables
+  std::size_t _block_size;
+  bool _huge_pages;
+
+  mutable Mutex _mutex;
+  std::vector<std::pair<void *, std::size_t>> _blocks;
+  std::size_t _offset = 0;
+  std::size_t _allocated = 0;
+
+  // Static variables
+  static constexpr std::size_t huge_page = std::size_t(1) << 21;
+  static constexpr std::size_t max_block_size = std::size_t(1) << 26;
+
+  // Concrete methods
+
+  // Offset in the last block of its next address with the given alignment
+  // (blocks themselves are only aligned for fundamental types)
+  std::size_t aligned(std::size_t alignment) const {
+    if (_blocks.empty()) return 0;
+    auto base = reinterpret_cast<std::uintptr_t>(_blocks.back().first);
+    return ((base + _offset + alignment - 1) & ~(alignment - 1)) - base;
+  }
+
+  void grow(std::size_t size) {
+    std::size_t block_size = std::max(_block_size, size);
+
+    void *block;
+    if (_huge_pages) {
+      block_size = (block_size + huge_page - 1) / huge_page * huge_page;
+      block = ::mmap(nullptr, block_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (block == MAP_FAILED) throw std::bad_alloc();
+      ::madvise(block, block_size, MADV_HUGEPAGE);
+    } else {
+      block = ::operator new(block_size);
+    }
+
+    _blocks.emplace_back(block, block_size);
+    _offset = 0;
+    _block_size = std::min(2 * _block_size, std::size_t(max_block_size));
+  }
+};
+
+// Alias
+using MonotonicArena = BasicMonotonicArena<std::mutex, atomic_refcount>;
+using MonotonicArenaPtr = MonotonicArena::SelfPtr;
+
+using LocalArena = BasicMonotonicArena<null_mutex, plain_refcount>;
+using LocalArenaPtr = LocalArena::SelfPtr;
+
+/* CLASS ArenaAllocator *******************************************************/
+
+/**
+ * @class ArenaAllocator
+ * Standard allocator taking memory from a MonotonicArena (or LocalArena),
+ * which is kept alive by the allocator (and so by everything allocated with
+ * it)
+ */
+template<typename T, typename Arena = MonotonicArena>
+class ArenaAllocator {
+ public:
+  // Alias
+  using value_type = T;
+  using ArenaPtr = typename Arena::SelfPtr;
+
+  // Constructors
+  explicit ArenaAllocator(ArenaPtr arena)
+      : _arena(std::move(arena)) {
+  }
+
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U, Arena> &other)
+      : _arena(other.arena()) {
+  }
+
+  // Operators
+  template<typename U>
+  bool operator==(const ArenaAllocator<U, Arena> &other) const {
+    return _arena == other.arena();
+  }
+
+  template<typename U>
+  bool operator!=(const ArenaAllocator<U, Arena> &other) const {
+    return _arena != other.arena();
+  }
+
+  // Concrete methods
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *pointer, std::size_t n) {
+    _arena->deallocate(pointer, n * sizeof(T));
+  }
+
+  const ArenaPtr &arena() const {
+    return _arena;
+  }
+
+ private:
+  // Instance variables
+  ArenaPtr _arena;
+};
+
+/* CLASS AllocatedAllocator ***************************************************/
+
+/**
+ * @class AllocatedAllocator
+ * Allocator adaptor taking memory from the given allocator, but building
+ * objects through allocated_access (see make_allocated)
+ */
+template<typename T, typename Alloc>
+class AllocatedAllocator {
+ public:
+  // Alias
+  using value_type = T;
+  using Inner
+    = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  template<typename U>
+  struct rebind {
+    using other = AllocatedAllocator<U, Alloc>;
+  };
+
+  // Constructors
+  explicit AllocatedAllocator(const Alloc &alloc)
+      : _inner(alloc) {
+  }
+
+  template<typename U>
+  AllocatedAllocator(const AllocatedAllocator<U, Alloc> &other)
+      : _inner(other.inner()) {
+  }
+
+  // Operators
+  template<typename U>
+  bool operator==(const AllocatedAllocator<U, Alloc> &other) const {
+    return _inner == other.inner();
+  }
+
+  template<typename U>
+  bool operator!=(const AllocatedAllocator<U, Alloc> &other) const {
+    return _inner != other.inner();
+  }
+
+  // Concrete methods
+  T *allocate(std::size_t n) {
+    return std::allocator_traits<Inner>::allocate(_inner, n);
+  }
+
+  void deallocate(T *pointer, std::size_t n) {
+    std::allocator_traits<Inner>::deallocate(_inner, pointer, n);
+  }
+
+  template<typename U, typename... Args>
+  void construct(U *pointer, Args&&... args) {
+    allocated_access::construct(pointer, std::forward<Args>(args)...);
+  }
+
+  template<typename U>
+  void destroy(U *pointer) {
+    pointer->~U();
+  }
+
+  const Inner &inner() const {
+    return _inner;
+  }
+
+ private:
+  // Instance variables
+  Inner _inner;
+};
+
+/* FUNCTION make_allocated ****************************************************/
+
+// Objects with a handle policy (`Handles`, see shared_handles) are owned
+// through it, like the ones built by their `make`
+
+template<typename T, typename = void>
+struct handles_of { using type = shared_handles; };
+
+template<typename T>
+struct handles_of<T, typename void_of<typename T::Handles>::type> {
+  using type = typename T::Handles;
+};
+
+template<typename T, typename Alloc, typename... Args>
+std::shared_ptr<T> make_allocated(const Alloc &alloc, Args&&... args) {
+  return handles_of<T>::type::own(
+    std::allocate_shared<T>(AllocatedAllocator<T, Alloc>(alloc),
+                            std::forward<Args>(args)...));
+}
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                 CALL PROFILER
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* STRUCT CallStats ***********************************************************/
+
+/**
+ * @struct CallStats
+ * Calls to a method of a front-end delegating to a model, with a histogram
+ * of their latencies: bucket `i` counts the calls lasting less than 2^(i+1)
+ * nanoseconds (and at least 2^i, except for the first bucket)
+ */
+struct CallStats {
+  // Static variables
+  static constexpr std::size_t buckets = 32;
+
+  // Instance variables
+  std::string front_end;
+  std::string model;
+  std::string method;
+  std::uint64_t calls = 0;
+  std::uint64_t nanoseconds = 0;
+  std::vector<std::uint64_t> histogram = std::vector<std::uint64_t>(buckets);
+
+  // Concrete methods
+  double mean() const {
+    return calls == 0 ? 0.0 : double(nanoseconds) / calls;
+  }
+
+  // Upper bound, in nanoseconds, of the bucket holding the q-quantile
+  std::uint64_t percentile(double q) const {
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < histogram.size(); i++) {
+      seen += histogram[i];
+      if (seen > 0 && seen >= q * calls) return std::uint64_t(2) << i;
+    }
+    return 0;
+  }
+};
+
+/* CLASS CallProfiler *********************************************************/
+
+/**
+ * @class CallProfiler
+ * Registry of the calls made through the delegator macros. Each thread
+ * counts its calls in its own counters, which are merged (and folded into
+ * the registry when the thread finishes) only when a snapshot is taken.
+ */
+class CallProfiler {
+ public:
+  // Static methods
+  static CallProfiler &instance() {
+    // Never destroyed, as threads may finish after static destruction
+    static CallProfiler *profiler = new CallProfiler();
+    return *profiler;
+  }
+
+  template<typename FrontEnd, typename Model>
+  static std::size_t site(const std::string &method) {
+    return instance().site(demangle(typeid(FrontEnd)),
+                           demangle(typeid(Model)), method);
+  }
+
+  static std::uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Concrete methods
+  std::size_t site(const std::string &front_end,
+                   const std::string &model,
+                   const std::string &method) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (std::size_t i = 0; i < _stats.size(); i++) {
+      if (_stats[i].front_end == front_end && _stats[i].model == model
+          && _stats[i].method == method) return i;
+    }
+    _stats.emplace_back();
+    _stats.back().front_end = front_end;
+    _stats.back().model = model;
+    _stats.back().method = method;
+    return _stats.size() - 1;
+  }
+
+  void record(std::size_t site, std::uint64_t nanoseconds) {
+    ThreadCounters &counters = local();
+
+    if (site >= counters.sites.size()) {
+      std::lock_guard<std::mutex> lock(counters.mutex);
+      while (counters.sites.size() <= site)
+        counters.sites.emplace_back(new Counters());
+    }
+
+    Counters &site_counters = *counters.sites[site];
+    bump(site_counters.calls, 1);
+    bump(site_counters.nanoseconds, nanoseconds);
+    bump(site_counters.histogram[bucket(nanoseconds)], 1);
+  }
+
+  std::vector<CallStats> snapshot() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<CallStats> stats = _stats;
+    for (const ThreadCounters *counters : _threads) {
+      std::lock_guard<std::mutex> counters_lock(counters->mutex);
+      for (std::size_t i = 0; i < counters->sites.size(); i++)
+        merge(stats[i], *counters->sites[i]);
+    }
+    return stats;
+  }
+
+  void report(std::ostream &out = std::cout) const {
+    out << "front-end\tmodel\tmethod\tcalls\tmean (ns)\tp50 (ns)\tp99 (ns)"
+        << std::endl;
+    for (const CallStats &stats : snapshot()) {
+      if (stats.calls == 0) continue;
+      out << stats.front_end << "\t" << stats.model << "\t" << stats.method
+          << "\t" << stats.calls << "\t" << stats.mean()
+          << "\t" << stats.percentile(0.5) << "\t" << stats.percentile(0.99)
+          << std::endl;
+    }
+  }
+
+ private:
+  // Inner structs
+  struct Counters {
+    // Padded on both sides, as `new` ignores over-alignment before C++17
+    char front_padding[64];
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> nanoseconds{0};
+    std::atomic<std::uint64_t> histogram[CallStats::buckets] = {};
+    char back_padding[64];
+  };
+
+  struct ThreadCounters {
+    // Guards the growth of `sites` against snapshots
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Counters>> sites;
+
+    ThreadCounters() {
+      std::lock_guard<std::mutex> lock(instance()._mutex);
+      instance()._threads.push_back(this);
+    }
+
+    ~ThreadCounters() {
+      instance().retire(*this);
+    }
+  };
+
+  // Instance variables
+  mutable std::mutex _mutex;
+  std::vector<CallStats> _stats;
+  std::vector<const ThreadCounters*> _threads;
+
+  // Constructors
+  CallProfiler() = default;
+
+  // Static methods
+  static ThreadCounters &local() {
+    static thread_local ThreadCounters counters;
+    return counters;
+  }
+
+  static std::string demangle(const std::type_info &type) {
+    int status = 0;
+    std::unique_ptr<char, void(*)(void*)> name(
+      abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), std::free);
+    return status == 0 ? name.get() : type.name();
+  }
+
+  static std::size_t bucket(std::uint64_t nanoseconds) {
+    if (nanoseconds == 0) return 0;
+    return std::min(std::size_t(63 - __builtin_clzll(nanoseconds)),
+                    CallStats::buckets - 1);
+  }
+
+  // Counters are only written by their own thread
+  static void bump(std::atomic<std::uint64_t> &counter, std::uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+  }
+
+  static void merge(CallStats &stats, const Counters &counters) {
+    stats.calls += counters.calls.load(std::memory_order_relaxed);
+    stats.nanoseconds += counters.nanoseconds.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < CallStats::buckets; i++)
+      stats.histogram[i] += counters.histogram[i].load(
+        std::memory_order_relaxed);
+  }
+
+  // Concrete methods
+  void retire(const ThreadCounters &counters) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (std::size_t i = 0; i < counters.sites.size(); i++)
+      merge(_stats[i], *counters.sites[i]);
+    _threads.erase(std::find(_threads.begin(), _threads.end(), &counters));
+  }
+};
+
+/* CLASS CallTimer ************************************************************/
+
+/**
+ * @class CallTimer
+ * Records in the CallProfiler the time elapsed from its construction to its
+ * destruction
+ */
+class CallTimer {
+ public:
+  // Constructors
+  explicit CallTimer(std::size_t site)
+      : _site(site), _start(CallProfiler::now()) {
+  }
+
+  CallTimer(const CallTimer &) = delete;
+  CallTimer &operator=(const CallTimer &) = delete;
+
+  // Destructor
+  ~CallTimer() {
+    CallProfiler::instance().record(_site, CallProfiler::now() - _start);
+  }
+
+ private:
+  // Instance variables
+  std::size_t _site;
+  std::uint64_t _start;
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                 FOO FRONT-END
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* CLASS Foo ******************************************************************/
+
+// Forward declaration
+template<typename T>
+class Foo;
+
+// Alias
+template<typename T>
+using FooPtr = std::shared_ptr<Foo<T>>;
+
+/**
+ * @class Foo
+ * Interface for implementation of Foo front-end
+ */
+template<typename T>
+class Foo : public std::enable_shared_from_this<Foo<T>> {
+ public:
+  // Destructor
+  virtual ~Foo() {}
+
+  // Virtual methods
+  virtual void method(const std::string &msg = "") const = 0;
+  virtual void method(Span<std::string> msgs) const = 0;
+
+  // Model the calls are delegated to
+  virtual const void *model() const = 0;
+};
+
+/* CLASS SimpleFoo ************************************************************/
+
+// Forward declaration
+template<typename T, typename M>
+class SimpleFoo;
+
+// Alias
+template<typename T, typename M>
+using SimpleFooPtr = std::shared_ptr<SimpleFoo<T, M>>;
+
+/**
+ * @class SimpleFoo
+ * Simple implementation of Foo front-end
+ */
+template<typename T, typename M>
+class SimpleFoo : public Foo<T>, public M::Handles::counted {
+ public:
+  // Alias
+  using MPtr = std::shared_ptr<M>;
+  using Handles = typename M::Handles;
+
+  // Constructor
+  SimpleFoo(MPtr m)
+      : _m(std::move(m)) {
+  }
+
+  // Overriden methods
+  void method(const std::string &msg) const override {
+    CALL_MEMBER_FUNCTION_DELEGATOR(method, msg);
+  }
+
+  void method(Span<std::string> msgs) const override {
+    CALL_MEMBER_FUNCTION_DELEGATOR(method, msgs);
+  }
+
+  const void *model() const override {
+    return _m.get();
+  }
+
+  // Concrete methods
+
+  // Model owning this front-end, if any (set by LazyFrontEnd)
+  const std::weak_ptr<const void> &owner() const {
+    return _owner;
+  }
+
+  void owner(std::weak_ptr<const void> model) {
+    _owner = std::move(model);
+  }
+
+ protected:
+  // Instance variables
+  MPtr _m;
+  std::weak_ptr<const void> _owner;
+
+ private:
+  GENERATE_MEMBER_FUNCTION_DELEGATOR(method, _m)
+};
+
+/* CLASS CachedFoo ************************************************************/
+
+// Forward declaration
+template<typename T, typename M>
+class CachedFoo;
+
+// Alias
+template<typename T, typename M>
+using CachedFooPtr = std::shared_ptr<CachedFoo<T, M>>;
+
+/**
+ * @class CachedFoo
+ * Cached implementation of Foo front-end
+ */
+template<typename T, typename M>
+class CachedFoo : public SimpleFoo<T, M> {
+ public:
+  // Alias
+  using MPtr = std::shared_ptr<M>;
+  using Cache = typename M::Cache;
+
+  // Constructor
+  CachedFoo(MPtr m, Cache cache = Cache())
+      : SimpleFoo<T,M>(std::move(m)), _cache(std::move(cache)) {
+  }
+
+  // Overriden methods
+  void method(const std::string &msg) const override {
+    CALL_MEMBER_FUNCTION_DELEGATOR(method, msg);
+  }
+
+  void method(Span<std::string> msgs) const override {
+    CALL_MEMBER_FUNCTION_DELEGATOR(method, msgs);
+  }
+
+  // Concrete methods
+  const Cache &cache() const {
+    return _cache;
+  }
+
+  // Looks the key up, computing and storing its value when missing
+  template<typename Compute>
+  typename Cache::mapped_type memoize(const typename Cache::key_type &key,
+                                      Compute compute) const {
+    return _cache.get(key, compute);
+  }
+
+ protected:
+  // Instance variables
+  mutable Cache _cache;
+
+ private:
+  GENERATE_MEMBER_FUNCTION_DELEGATOR(method, _m)
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                   CONCURRENCY
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* CLASS WorkStealingPool *****************************************************/
+
+/**
+ * @class WorkStealingPool
+ * Thread pool where each worker has its own deque of tasks: a worker takes
+ * the newest tasks from its deque and, when it is empty, steals the oldest
+ * tasks from the other ones
+ */
+class WorkStealingPool {
+ public:
+  // Alias
+  using Task = std::function<void()>;
+
+  // Constructors
+  explicit WorkStealingPool(
+      unsigned int threads = std::thread::hardware_concurrency())
+      : _queues(std::max(threads, 1u)) {
+    for (unsigned int i = 0; i < _queues.size(); i++)
+      _workers.emplace_back([this, i] { work(i); });
+  }
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  // Destructor
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _wakeup.notify_all();
+    for (auto &worker : _workers) worker.join();
+  }
+
+  // Concrete methods
+  unsigned int size() const {
+    return _queues.size();
+  }
+
+  // Index of the calling thread among the workers, or -1 if not a worker
+  int index() const {
+    const auto &current = current_worker();
+    return current.first == this ? current.second : -1;
+  }
+
+  void submit(Task task) {
+    int i = index();
+    Queue &queue = _queues[i >= 0 ? i : _next++ % _queues.size()];
+    _queued++;  // Before the task can be taken (and the counter decreased)
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+    }
+    _wakeup.notify_one();
+  }
+
+  bool run_pending() {
+    Task task;
+    if (!take(task)) return false;
+    task();
+    return true;
+  }
+
+ private:
+  // Inner structs
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  // Instance variables
+  std::vector<Queue> _queues;
+  std::vector<std::thread> _workers;
+
+  std::mutex _mutex;
+  std::condition_variable _wakeup;
+  std::atomic<std::size_t> _queued { 0 };
+  std::atomic<std::size_t> _next { 0 };
+  bool _stop = false;
+
+  // Static methods
+  static std::pair<const WorkStealingPool*, int> &current_worker() {
+    thread_local std::pair<const WorkStealingPool*, int> current(nullptr, -1);
+    return current;
+  }
+
+  // Concrete methods
+  bool take(Task &task) {
+    int i = index();
+    std::size_t n = _queues.size();
+
+    for (std::size_t k = 0; k < n; k++) {
+      bool own = (i >= 0 && k == 0);
+      Queue &queue = _queues[(std::max(i, 0) + k) % n];
+
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) continue;
+
+      if (own) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      _queued--;
+      return true;
+    }
+
+    return false;
+  }
+
+  void work(int i) {
+    current_worker() = std::make_pair(this, i);
+    while (true) {
+      if (run_pending()) continue;
+      std::unique_lock<std::mutex> lock(_mutex);
+      _wakeup.wait(lock, [this] { return _stop || _queued > 0; });
+      if (_stop && _queued == 0) return;
+    }
+  }
+};
+
+/* CLASS TaskGroup ************************************************************/
+
+/**
+ * @class TaskGroup
+ * Set of tasks submitted to a pool that can be waited together. Workers
+ * waiting for a group run other pending tasks meanwhile, so groups can be
+ * nested. The first exception thrown by a task is rethrown by wait().
+ */
+class TaskGroup {
+ public:
+  // Constructors
+  explicit TaskGroup(WorkStealingPool &pool)
+      : _pool(pool) {
+  }
+
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  // Destructor
+  ~TaskGroup() {
+    synchronize();
+  }
+
+  // Concrete methods
+  template<typename Function>
+  void run(Function function) {
+    _pending++;
+    _pool.submit([this, function] {
+      try {
+        function();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_error) _error = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (--_pending == 0) _done.notify_all();
+    });
+  }
+
+  void wait() {
+    synchronize();
+    if (_error) {
+      std::exception_ptr error = _error;
+      _error = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+ private:
+  // Instance variables
+  WorkStealingPool &_pool;
+
+  std::mutex _mutex;
+  std::condition_variable _done;
+  std::atomic<std::size_t> _pending { 0 };
+  std::exception_ptr _error;
+
+  // Concrete methods
+  void synchronize() {
+    bool worker = (_pool.index() >= 0);
+    while (_pending > 0) {
+      if (worker && _pool.run_pending()) continue;
+      std::unique_lock<std::mutex> lock(_mutex);
+      _done.wait_for(lock, std::chrono::microseconds(50),
+                     [this] { return _pending == 0; });
+    }
+    // Tasks finish while holding the mutex
+    std::lock_guard<std::mutex> lock(_mutex);
+  }
+};
+
+/* STRUCT parallel_policy *****************************************************/
+
+// Execution policy running independent steps as tasks of a pool, in place
+// of std::execution::par (not available in C++14)
+struct parallel_policy {
+  WorkStealingPool &pool;
+};
+
+/* CLASS BatchingExecutor *****************************************************/
+
+/**
+ * @class BatchingExecutor
+ * Executor running calls to Foo front-ends as tasks of a pool. Calls to the
+ * same model, through front-ends of the same class (such as distinct simple
+ * front-ends of a model, or copies of its lazy one), made before its pending
+ * task starts are coalesced into one batch, up to `max_batch` messages, run
+ * by the batched `method` of the first of those front-ends. Futures should
+ * not be waited by workers of the pool.
+ */
+class BatchingExecutor {
+ public:
+  // Constructors
+  explicit BatchingExecutor(WorkStealingPool &pool,
+                            std::size_t max_batch = 64)
+      : _max_batch(std::max<std::size_t>(max_batch, 1)), _tasks(pool) {
+  }
+
+  BatchingExecutor(const BatchingExecutor &) = delete;
+  BatchingExecutor &operator=(const BatchingExecutor &) = delete;
+
+  // Concrete methods
+  template<typename T>
+  std::future<void> submit(FooPtr<T> foo, std::string msg) {
+    Key key{ foo->model(), typeid(*foo) };
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::shared_ptr<Batch> &batch = _open[key];
+    if (!batch) {
+      batch = std::make_shared<Batch>();
+      batch->run = [foo](Span<std::string> msgs) { foo->method(msgs); };
+      _tasks.run([this, key, open = batch] { execute(key, open); });
+    }
+
+    batch->msgs.push_back(std::move(msg));
+    batch->promises.emplace_back();
+    std::future<void> future = batch->promises.back().get_future();
+
+    if (batch->msgs.size() >= _max_batch) _open.erase(key);
+    return future;
+  }
+
+  // Number of batches run so far
+  std::size_t batches() const {
+    return _batches;
+  }
+
+ private:
+  // Inner structs
+  struct Key {
+    const void *model;
+    std::type_index front_end;
+
+    bool operator==(const Key &other) const {
+      return model == other.model && front_end == other.front_end;
+    }
+  };
+
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const {
+      return std::hash<const void*>{}(key.model) ^ key.front_end.hash_code();
+    }
+  };
+
+  struct Batch {
+    std::function<void(Span<std::string>)> run;
+    std::vector<std::string> msgs;
+    std::vector<std::promise<void>> promises;
+  };
+
+  // Instance variables
+  std::size_t _max_batch;
+  std::atomic<std::size_t> _batches { 0 };
+
+  std::mutex _mutex;
+  std::unordered_map<Key, std::shared_ptr<Batch>, KeyHash> _open;
+
+  // Destroyed first, waiting for the tasks using the members above
+  TaskGroup _tasks;
+
+  // Concrete methods
+  void execute(const Key &key, const std::shared_ptr<Batch> &batch) {
+    {
+      // Calls made from now on start a new batch
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto open = _open.find(key);
+      if (open != _open.end() && open->second == batch) _open.erase(open);
+    }
+
+    _batches++;
+    try {
+      batch->run(Span<std::string>(batch->msgs));
+    } catch (...) {
+      for (auto &promise : batch->promises)
+        promise.set_exception(std::current_exception());
+      return;
+    }
+    for (auto &promise : batch->promises) promise.set_value();
+  }
+};
+
+/* CLASS AsyncFoo *************************************************************/
+
+/**
+ * @class AsyncFoo
+ * Asynchronous counterpart of Foo front-end: each call is enqueued on an
+ * executor, and its completion (or exception) is reported by a future
+ */
+template<typename T>
+class AsyncFoo {
+ public:
+  // Constructors
+  AsyncFoo(FooPtr<T> foo, BatchingExecutor &executor)
+      : _foo(std::move(foo)), _executor(executor) {
+  }
+
+  // Concrete methods
+  std::future<void> method(std::string msg = "") const {
+    return _executor.submit(_foo, std::move(msg));
+  }
+
+  const FooPtr<T> &foo() const {
+    return _foo;
+  }
+
+ private:
+  // Instance variables
+  FooPtr<T> _foo;
+  BatchingExecutor &_executor;
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                    DUMP SINK
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* CLASS Sink *****************************************************************/
+
+// Forward declaration
+class Sink;
+
+// Alias
+using SinkPtr = std::shared_ptr<Sink>;
+
+/**
+ * @class Sink
+ * Destination of dumps. Texts given to `write` are only valid during the
+ * call, and reach their destination at the latest on `flush`
+ */
+class Sink {
+ public:
+  // Destructor
+  virtual ~Sink() {}
+
+  // Purely virtual methods
+  virtual void write(Span<char> text) = 0;
+  virtual void flush() = 0;
+};
+
+/* CLASS StreamSink ***********************************************************/
+
+// Forward declaration
+class StreamSink;
+
+// Alias
+using StreamSinkPtr = std::shared_ptr<StreamSink>;
+
+/**
+ * @class StreamSink
+ * Sink writing to a std::ostream, relying on its own buffer
+ */
+class StreamSink : public Sink {
+ public:
+  // Static methods
+  template<typename... Args>
+  static StreamSinkPtr make(Args&&... args) {
+    return StreamSinkPtr(new StreamSink(std::forward<Args>(args)...));
+  }
+
+  static const StreamSinkPtr &standard() {
+    static const StreamSinkPtr sink = make(std::cout);
+    return sink;
+  }
+
+  // Overriden methods
+  void write(Span<char> text) override {
+    _stream.write(text.begin(), text.size());
+  }
+
+  void flush() override {
+    _stream.flush();
+  }
+
+ protected:
+  // Instance variables
+  std::ostream &_stream;
+
+  // Constructors
+  explicit StreamSink(std::ostream &stream)
+      : _stream(stream) {
+  }
+};
+
+/* CLASS BufferSink ***********************************************************/
+
+// Forward declaration
+class BufferSink;
+
+// Alias
+using BufferSinkPtr = std::shared_ptr<BufferSink>;
+
+/**
+ * @class BufferSink
+ * Sink accumulating everything written in memory
+ */
+class BufferSink : public Sink {
+ public:
+  // Static methods
+  template<typename... Args>
+  static BufferSinkPtr make(Args&&... args) {
+    return BufferSinkPtr(new BufferSink(std::forward<Args>(args)...));
+  }
+
+  // Overriden methods
+  void write(Span<char> text) override {
+    _buffer.append(text.begin(), text.size());
+  }
+
+  void flush() override {
+  }
+
+  // Concrete methods
+  const std::string &str() const {
+    return _buffer;
+  }
+
+  void clear() {
+    _buffer.clear();
+  }
+
+ protected:
+  // Instance variables
+  std::string _buffer;
+
+  // Constructors
+  BufferSink() = default;
+};
+
+/* CLASS DescriptorSink *******************************************************/
+
+// Forward declaration
+class DescriptorSink;
+
+// Alias
+using DescriptorSinkPtr = std::shared_ptr<DescriptorSink>;
+
+/**
+ * @class DescriptorSink
+ * Sink writing to a (not owned) file descriptor. Small texts are batched in
+ * a buffer, while texts of at least half of its capacity are written along
+ * with the buffer in a single scatter-gather call, without being copied
+ */
+class DescriptorSink : public Sink {
+ public:
+  // Static methods
+  template<typename... Args>
+  static DescriptorSinkPtr make(Args&&... args) {
+    return DescriptorSinkPtr(new DescriptorSink(std::forward<Args>(args)...));
+  }
+
+  // Destructor
+  ~DescriptorSink() override {
+    try { flush(); } catch (...) {}
+  }
+
+  // Overriden methods
+  void write(Span<char> text) override {
+    if (_buffer.size() + text.size() <= _capacity) {
+      _buffer.append(text.begin(), text.size());
+    } else if (2 * text.size() < _capacity) {
+      flush();
+      _buffer.append(text.begin(), text.size());
+    } else {
+      iovec segments[2] = {
+        { &_buffer[0], _buffer.size() },
+        { const_cast<char *>(text.begin()), text.size() }
+      };
+      writeAll(segments, 2);
+      _buffer.clear();
+    }
+  }
+
+  void flush() override {
+    if (_buffer.empty()) return;
+    iovec segment = { &_buffer[0], _buffer.size() };
+    writeAll(&segment, 1);
+    _buffer.clear();
+  }
+
+ protected:
+  // Instance variables
+  int _fd;
+  std::size_t _capacity;
+  std::string _buffer;
+
+  // Constructors
+  explicit DescriptorSink(int fd, std::size_t capacity = 1 << 16)
+      : _fd(fd), _capacity(std::max<std::size_t>(capacity, 1)) {
+    _buffer.reserve(_capacity);
+  }
+
+ private:
+  // Concrete methods
+  void writeAll(iovec *segments, int count) {
+    while (count > 0) {
+      ssize_t written = ::writev(_fd, segments, count);
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        throw std::system_error(errno, std::generic_category(), "writev");
+      }
+
+      auto remaining = static_cast<std::size_t>(written);
+      while (count > 0 && remaining >= segments->iov_len) {
+        remaining -= segments->iov_len;
+        segments++;
+        count--;
+      }
+      if (count > 0) {
+        char *base = static_cast<char *>(segments->iov_base);
+        segments->iov_base = base + remaining;
+        segments->iov_len -= remaining;
+      }
+    }
+  }
+};
+
+/* CLASS FileSink *************************************************************/
+
+// Forward declaration
+class FileSink;
+
+// Alias
+using FileSinkPtr = std::shared_ptr<FileSink>;
+
+/**
+ * @class FileSink
+ * DescriptorSink owning a file, truncated when opened
+ */
+class FileSink : public DescriptorSink {
+ public:
+  // Static methods
+  template<typename... Args>
+  static FileSinkPtr make(Args&&... args) {
+    return FileSinkPtr(new FileSink(std::forward<Args>(args)...));
+  }
+
+  // Destructor
+  ~FileSink() override {
+    try { flush(); } catch (...) {}
+    ::close(_fd);
+  }
+
+ protected:
+  // Constructors
+  explicit FileSink(const std::string &path, std::size_t capacity = 1 << 16)
+      : DescriptorSink(open(path), capacity) {
+  }
+
+ private:
+  // Static methods
+  static int open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), path);
+    return fd;
+  }
+};
+
+/* CLASS AsyncSink ************************************************************/
+
+// Forward declaration
+class AsyncSink;
+
+// Alias
+using AsyncSinkPtr = std::shared_ptr<AsyncSink>;
+
+/**
+ * @class AsyncSink
+ * Sink copying texts into a buffer which, when full, is handed to a
+ * background thread that writes it into another sink. The caller only
+ * waits if the previous buffer is still being written. Errors of the
+ * background thread are rethrown by the next call
+ */
+class AsyncSink : public Sink {
+ public:
+  // Static methods
+  template<typename... Args>
+  static AsyncSinkPtr make(Args&&... args) {
+    return AsyncSinkPtr(new AsyncSink(std::forward<Args>(args)...));
+  }
+
+  // Destructor
+  ~AsyncSink() override {
+    try { flush(); } catch (...) {}
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopped = true;
+    }
+    _condition.notify_all();
+    _writer.join();
+  }
+
+  // Overriden methods
+  void write(Span<char> text) override {
+    _front.append(text.begin(), text.size());
+    if (_front.size() >= _capacity) handOff();
+  }
+
+  void flush() override {
+    handOff();
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [this] { return !_pending; });
+    rethrow();
+    _sink->flush();
+  }
+
+ protected:
+  // Constructors
+  explicit AsyncSink(SinkPtr sink, std::size_t capacity = 1 << 16)
+      : _sink(std::move(sink)), _capacity(std::max<std::size_t>(capacity, 1)),
+        _pending(false), _stopped(false), _writer([this] { work(); }) {
+    _front.reserve(_capacity);
+  }
+
+ private:
+  // Instance variables
+  SinkPtr _sink;
+  std::size_t _capacity;
+
+  std::string _front;  // Filled by the caller
+  std::string _back;   // Written by the background thread
+
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  bool _pending;
+  bool _stopped;
+  std::exception_ptr _error;
+
+  std::thread _writer;
+
+  // Concrete methods
+  void handOff() {
+    if (_front.empty()) return;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this] { return !_pending; });
+      rethrow();
+      std::swap(_front, _back);
+      _pending = true;
+    }
+    _condition.notify_all();
+    _front.clear();
+  }
+
+  void rethrow() {
+    if (_error) {
+      std::exception_ptr error = _error;
+      _error = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  void work() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+      _condition.wait(lock, [this] { return _pending || _stopped; });
+      if (!_pending) return;
+
+      lock.unlock();
+      try {
+        _sink->write(Span<char>(_back.data(), _back.size()));
+      } catch (...) {
+        std::lock_guard<std::mutex> error_lock(_mutex);
+        _error = std::current_exception();
+      }
+      lock.lock();
+
+      _pending = false;
+      _condition.notify_all();
+    }
+  }
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                     TRACER
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* STRUCT TraceEvent **********************************************************/
+
+/**
+ * @struct TraceEvent
+ * Span of time spent by a thread in a traced method, in nanoseconds since
+ * the tracer was created
+ */
+struct TraceEvent {
+  const char *name;
+  unsigned int thread;
+  std::uint64_t begin;
+  std::uint64_t end;
+};
+
+/* CLASS Tracer ***************************************************************/
+
+/**
+ * @class Tracer
+ * Recorder of the spans of traced methods, disabled by default. Each thread
+ * records its spans in a ring buffer of its own, keeping only the newest
+ * ones, which are collected when events are requested.
+ */
+class Tracer {
+ public:
+  // Static variables
+  static constexpr std::size_t capacity = 1 << 14;  // Events per thread
+
+  // Static methods
+  static Tracer &instance() {
+    // Never destroyed, as threads may finish after static destruction
+    static Tracer *tracer = new Tracer();
+    return *tracer;
+  }
+
+  static bool enabled() {
+    return flag().load(std::memory_order_relaxed);
+  }
+
+  static void enable(bool enabled = true) {
+    instance();  // Sets the epoch before any span is recorded
+    flag().store(enabled, std::memory_order_relaxed);
+  }
+
+  // Concrete methods
+  void record(const char *name, std::uint64_t begin, std::uint64_t end) {
+    Ring &ring = local();
+    std::uint64_t i = ring.head.load(std::memory_order_relaxed);
+
+    // Readers seeing any part of this event also see that slot `i` is being
+    // overwritten, and discard it (see `collect`)
+    std::atomic_thread_fence(std::memory_order_release);
+    Slot &slot = ring.slots[i & (capacity - 1)];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.begin.store(begin - _epoch, std::memory_order_relaxed);
+    slot.end.store(end - _epoch, std::memory_order_relaxed);
+
+    ring.head.store(i + 1, std::memory_order_release);
+  }
+
+  std::vector<TraceEvent> events() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<TraceEvent> events = _retired;
+    for (const Ring *ring : _rings) collect(*ring, events);
+    std::sort(events.begin(), events.end(),
+              [](const TraceEvent &a, const TraceEvent &b) {
+                return a.begin < b.begin;
+              });
+    return events;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _retired.clear();
+    for (Ring *ring : _rings)
+      ring->cleared.store(ring->head.load(std::memory_order_acquire),
+                          std::memory_order_relaxed);
+  }
+
+  // Writes the events in Chrome trace-event format (chrome://tracing)
+  void dump(Sink &sink) const {
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+    for (const TraceEvent &event : events()) {
+      json += first ? "\n" : ",\n";
+      json += "{\"name\":\"" + std::string(event.name) + "\",\"cat\":\"tops\","
+              "\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(event.thread)
+            + ",\"ts\":" + microseconds(event.begin)
+            + ",\"dur\":" + microseconds(event.end - event.begin) + "}";
+      first = false;
+    }
+    json += "\n]}\n";
+    sink.write(Span<char>(json.data(), json.size()));
+    sink.flush();
+  }
+
+ private:
+  // Inner structs
+  struct Slot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<std::uint64_t> begin{0};
+    std::atomic<std::uint64_t> end{0};
+  };
+
+  struct Ring {
+    unsigned int thread;
+    std::atomic<std::uint64_t> head{0};
+    std::atomic<std::uint64_t> cleared{0};
+    std::unique_ptr<Slot[]> slots{new Slot[capacity]};
+
+    Ring() {
+      Tracer &tracer = instance();
+      std::lock_guard<std::mutex> lock(tracer._mutex);
+      thread = ++tracer._threads;
+      tracer._rings.push_back(this);
+    }
+
+    ~Ring() {
+      Tracer &tracer = instance();
+      std::lock_guard<std::mutex> lock(tracer._mutex);
+      collect(*this, tracer._retired);
+      tracer._rings.erase(
+        std::find(tracer._rings.begin(), tracer._rings.end(), this));
+    }
+  };
+
+  // Instance variables
+  mutable std::mutex _mutex;
+  std::vector<Ring*> _rings;
+  std::vector<TraceEvent> _retired;
+  unsigned int _threads = 0;
+  std::uint64_t _epoch = CallProfiler::now();
+
+  // Constructors
+  Tracer() = default;
+
+  // Static methods
+  static std::atomic<bool> &flag() {
+    static std::atomic<bool> enabled{false};
+    return enabled;
+  }
+
+  static Ring &local() {
+    static thread_local Ring ring;
+    return ring;
+  }
+
+  static void collect(const Ring &ring, std::vector<TraceEvent> &events) {
+    std::uint64_t head = ring.head.load(std::memory_order_acquire);
+    std::uint64_t first = std::max(
+      ring.cleared.load(std::memory_order_relaxed),
+      head > capacity ? head - capacity : 0);
+
+    std::vector<TraceEvent> read;
+    for (std::uint64_t i = first; i < head; i++) {
+      const Slot &slot = ring.slots[i & (capacity - 1)];
+      read.push_back({ slot.name.load(std::memory_order_relaxed), ring.thread,
+                       slot.begin.load(std::memory_order_relaxed),
+                       slot.end.load(std::memory_order_relaxed) });
+    }
+
+    // Events overwritten while being read are discarded
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::uint64_t last = ring.head.load(std::memory_order_relaxed);
+    std::uint64_t valid = last >= capacity ? last - capacity + 1 : 0;
+    for (std::uint64_t i = first; i < head; i++)
+      if (i >= valid) events.push_back(read[i - first]);
+  }
+
+  static std::string microseconds(std::uint64_t nanoseconds) {
+    std::string fraction = std::to_string(nanoseconds % 1000);
+    return std::to_string(nanoseconds / 1000) + "."
+         + std::string(3 - fraction.size(), '0') + fraction;
+  }
+};
+
+/* CLASS TraceSpan ************************************************************/
+
+/**
+ * @class TraceSpan
+ * Records in the Tracer, if enabled, the span from its construction to its
+ * destruction. The name must outlive the tracer (e.g. a string literal).
+ */
+class TraceSpan {
+ public:
+  // Constructors
+  explicit TraceSpan(const char *name)
+      : _name(Tracer::enabled() ? name : nullptr),
+        _begin(_name ? CallProfiler::now() : 0) {
+  }
+
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+  // Destructor
+  ~TraceSpan() {
+    if (_name) Tracer::instance().record(_name, _begin, CallProfiler::now());
+  }
+
+ private:
+  // Instance variables
+  const char *_name;
+  std::uint64_t _begin;
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                   WORD SOURCE
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* CLASS FileMapping **********************************************************/
+
+// Forward declaration
+class FileMapping;
+
+// Alias
+using FileMappingPtr = std::shared_ptr<FileMapping>;
+
+/**
+ * @class FileMapping
+ * Read-only, private memory mapping of a whole file, unmapped when
+ * destroyed. Errors opening, inspecting or mapping the file are thrown as
+ * std::system_error
+ */
+class FileMapping {
+ public:
+  // Static methods
+  template<typename... Args>
+  static FileMappingPtr make(Args&&... args) {
+    return FileMappingPtr(new FileMapping(std::forward<Args>(args)...));
+  }
+
+  // Constructors
+  explicit FileMapping(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), path);
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+      int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), path);
+    }
+    if (status.st_size > 0) {
+      _size = static_cast<std::size_t>(status.st_size);
+      _data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    int error = errno;
+    ::close(fd);
+
+    if (_data == MAP_FAILED) {
+      _size = 0;
+      throw std::system_error(error, std::generic_category(), path);
+    }
+  }
+
+  FileMapping(const FileMapping &) = delete;
+  FileMapping &operator=(const FileMapping &) = delete;
+
+  // Destructor
+  ~FileMapping() {
+    if (_size > 0) ::munmap(_data, _size);
+  }
+
+  // Concrete methods
+  void *data() const {
+    return _data;
+  }
+
+  std::size_t size() const {
+    return _size;
+  }
+
+ private:
+  // Instance variables
+  void *_data = nullptr;
+  std::size_t _size = 0;
+};
+
+/* CLASS WordSource ***********************************************************/
+
+// Forward declaration
+class WordSource;
+
+// Alias
+using WordSourcePtr = std::shared_ptr<WordSource>;
+
+/**
+ * @class WordSource
+ * Origin of text read in chunks, which are valid until the next read.
+ * Words may be split between consecutive chunks
+ */
+class WordSource {
+ public:
+  // Destructor
+  virtual ~WordSource() {}
+
+  // Purely virtual methods
+  virtual bool read(Span<char> &chunk) = 0;
+};
+
+/* CLASS MemorySource *********************************************************/
+
+// Forward declaration
+class MemorySource;
+
+// Alias
+using MemorySourcePtr = std::shared_ptr<MemorySource>;
+
+/**
+ * @class MemorySource
+ * Source of text held in memory, given in a single chunk
+ */
+class MemorySource : public WordSource {
+ public:
+  // Static methods
+  template<typename... Args>
+  static MemorySourcePtr make(Args&&... args) {
+    return MemorySourcePtr(new MemorySource(std::forward<Args>(args)...));
+  }
+
+  // Overriden methods
+  bool read(Span<char> &chunk) override {
+    if (_read) return false;
+    chunk = Span<char>(_text.data(), _text.size());
+    _read = true;
+    return true;
+  }
+
+ protected:
+  // Instance variables
+  std::string _text;
+  bool _read = false;
+
+  // Constructors
+  explicit MemorySource(std::string text)
+      : _text(std::move(text)) {
+  }
+};
+
+/* CLASS StreamSource *********************************************************/
+
+// Forward declaration
+class StreamSource;
+
+// Alias
+using StreamSourcePtr = std::shared_ptr<StreamSource>;
+
+/**
+ * @class StreamSource
+ * Source reading a std::istream in chunks of fixed capacity
+ */
+class StreamSource : public WordSource {
+ public:
+  // Static methods
+  template<typename... Args>
+  static StreamSourcePtr make(Args&&... args) {
+    return StreamSourcePtr(new StreamSource(std::forward<Args>(args)...));
+  }
+
+  // Overriden methods
+  bool read(Span<char> &chunk) override {
+    _stream.read(&_buffer[0], static_cast<std::streamsize>(_buffer.size()));
+    auto size = static_cast<std::size_t>(_stream.gcount());
+    if (size == 0) return false;
+    chunk = Span<char>(_buffer.data(), size);
+    return true;
+  }
+
+ protected:
+  // Instance variables
+  std::istream &_stream;
+  std::string _buffer;
+
+  // Constructors
+  explicit StreamSource(std::istream &stream, std::size_t capacity = 1 << 16)
+      : _stream(stream), _buffer(std::max<std::size_t>(capacity, 1), '\0') {
+  }
+};
+
+/* CLASS MappedSource *********************************************************/
+
+// Forward declaration
+class MappedSource;
+
+// Alias
+using MappedSourcePtr = std::shared_ptr<MappedSource>;
+
+/**
+ * @class MappedSource
+ * Source of a memory-mapped file, given in chunks read in place. Pages of
+ * chunks already read are released, so the mapping itself keeps only the
+ * current chunk resident (whatever consumes the chunks, such as a word
+ * store, still keeps its own copy of them)
+ */
+class MappedSource : public WordSource {
+ public:
+  // Static methods
+  template<typename... Args>
+  static MappedSourcePtr make(Args&&... args) {
+    return MappedSourcePtr(new MappedSource(std::forward<Args>(args)...));
+  }
+
+  // Overriden methods
+  bool read(Span<char> &chunk) override {
+    release();
+    if (_offset == _size) return false;
+
+    std::size_t size = std::min(_chunk, _size - _offset);
+    chunk = Span<char>(_data + _offset, size);
+    _offset += size;
+    return true;
+  }
+
+ protected:
+  // Instance variables
+  FileMapping _mapping;
+  char *_data;
+  std::size_t _size;
+  std::size_t _chunk;
+  std::size_t _offset = 0;
+  std::size_t _released = 0;
+
+  // Constructors
+  explicit MappedSource(const std::string &path,
+                        std::size_t chunk = std::size_t(1) << 24)
+      : _mapping(path), _data(static_cast<char *>(_mapping.data())),
+        _size(_mapping.size()),
+        _chunk(std::max<std::size_t>(pageAligned(chunk), page())) {
+    if (_size > 0) ::madvise(_data, _size, MADV_SEQUENTIAL);
+  }
+
+ private:
+  // Static methods
+  static std::size_t page() {
+    return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  }
+
+  static std::size_t pageAligned(std::size_t size) {
+    return size / page() * page();
+  }
+
+  // Concrete methods
+  void release() {
+    std::size_t released = pageAligned(_offset);
+    if (released > _released) {
+      ::madvise(_data + _released,
+                released - _released, MADV_DONTNEED);
+      _released = released;
+    }
+  }
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                               VISITOR FRONT-END
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* CLASS Visitor **************************************************************/
+
+// Forward declaration
+class Visitor;
+
+// Alias
+using VisitorPtr = std::shared_ptr<Visitor>;
+
+// Forward declaration
+class Baz;
+class BarDerived;
+class BarReusing;
+
+class Visitor {
+ public:
+  // Purely virtual functions
+  virtual void visit(std::shared_ptr<Baz> top) = 0;
+  virtual void visit(std::shared_ptr<BarDerived> top) = 0;
+  virtual void visit(std::shared_ptr<BarReusing> top) = 0;
+
+  // Virtual methods (parallel traversals require visitors that are either
+  // thread-safe, with one instance shared by all threads, or clonable, with
+  // one clone per thread merged back into the original at the end)
+  virtual bool thread_safe() const {
+    return false;
+  }
+
+  virtual VisitorPtr clone() const {
+    return nullptr;
+  }
+
+  virtual void merge(const Visitor &/* clone */) {
+  }
+};
+
+/* CLASS Acceptor *************************************************************/
+
+// Forward declaration
+class Acceptor;
+
+// Alias
+using AcceptorPtr = std::shared_ptr<Acceptor>;
+
+/**
+ * @class Acceptor
+ * Interface for implementation of Acceptor front-end
+ */
+class Acceptor : public std::enable_shared_from_this<Acceptor> {
+ public:
+  // Enum classes
+  enum class traversal { pre_order, post_order };
+
+  // Destructor
+  virtual ~Acceptor() {}
+
+  // Concrete methods
+  void pre_order() {
+    accept(traversal::pre_order);
+  }
+
+  void post_order() {
+    accept(traversal::post_order);
+  }
+
+  // Subtrees with up to `cutoff` nodes are traversed serially
+  void pre_order(WorkStealingPool &pool, std::size_t cutoff = 1024) {
+    accept(traversal::pre_order, pool, cutoff);
+  }
+
+  void post_order(WorkStealingPool &pool, std::size_t cutoff = 1024) {
+    accept(traversal::post_order, pool, cutoff);
+  }
+
+  // Virtual methods
+  virtual void accept(const traversal& type = traversal::post_order) = 0;
+  virtual void accept(const traversal& type,
+                      WorkStealingPool &pool, std::size_t cutoff) = 0;
+};
+
+/* CLASS SimpleAcceptor *******************************************************/
+
+// Forward declaration
+template<typename M>
+class SimpleAcceptor;
+
+// Alias
+template<typename M>
+using SimpleAcceptorPtr = std::shared_ptr<SimpleAcceptor<M>>;
+
+/**
+ * @class SimpleAcceptor
+ * Simple implementation of Acceptor front-end, holding its model with a
+ * handle of the model's policy
+ */
+template<typename M>
+class SimpleAcceptor : public Acceptor, public M::Handles::counted {
+ public:
+  // Alias
+  using Handles = typename M::Handles;
+  using MHandle = typename Handles::template handle<M>;
+
+  // Constructor
+  SimpleAcceptor(MHandle m, VisitorPtr visitor)
+      : _m(std::move(m)), _visitor(visitor) {
+  }
+
+  // Overriden methods
+  void accept(const Acceptor::traversal& type) override {
+    TraceSpan span("Acceptor::accept");
+    CALL_MEMBER_FUNCTION_DELEGATOR(accept, type);
+  }
+
+  void accept(const Acceptor::traversal& type,
+              WorkStealingPool &pool, std::size_t cutoff) override {
+    TraceSpan span("Acceptor::accept");
+    CALL_MEMBER_FUNCTION_DELEGATOR(accept, type, pool, cutoff);
+  }
+
+  // Concrete methods
+  const VisitorPtr &visitor() const {
+    return _visitor;
+  }
+
+ protected:
+  // Instance variables
+  MHandle _m;
+  VisitorPtr _visitor;
+
+ private:
+  GENERATE_MEMBER_FUNCTION_DELEGATOR(accept, _m)
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                               CREATOR ALGORITHMS
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* STRUCT creator_algorithm_tag ***********************************************/
+
+struct creator_algorithm_tag {};
+
+struct creator_carriage_tag : public creator_algorithm_tag {};
+struct creator_newline_tag : public creator_algorithm_tag {};
+struct creator_space_tag : public creator_algorithm_tag {};
+struct creator_tab_tag : public creator_algorithm_tag {};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                               CREATOR FRONT-END
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* STRUCT memoizable **********************************************************/
+
+// Arguments of create() that can be memoized: empty ones (e.g. tags), or
+// values both hashable and equality comparable. Pointers (raw or smart) are
+// not, as the objects they point to may change, or be replaced by others
+// at the same address
+
+template<typename Arg>
+struct is_pointer_like : public std::is_pointer<Arg> {};
+
+template<typename Arg>
+struct is_pointer_like<std::shared_ptr<Arg>> : public std::true_type {};
+
+template<typename Arg, typename Deleter>
+struct is_pointer_like<std::unique_ptr<Arg, Deleter>>
+  : public std::true_type {};
+
+template<typename Arg, typename = void>
+struct is_memo_value : public std::false_type {};
+
+template<typename Arg>
+struct is_memo_value<Arg, decltype(
+    std::hash<Arg>{}(std::declval<const Arg &>()),
+    void(std::declval<const Arg &>() == std::declval<const Arg &>()))>
+  : public std::integral_constant<bool, !is_pointer_like<Arg>::value> {};
+
+template<typename... Args>
+struct memoizable : public std::true_type {};
+
+template<typename Arg, typename... Args>
+struct memoizable<Arg, Args...>
+  : public std::integral_constant<bool,
+      (std::is_empty<Arg>::value || is_memo_value<Arg>::value)
+      && memoizable<Args...>::value> {};
+
+/* CLASS MemoKey **************************************************************/
+
+/**
+ * @class MemoKey
+ * Arguments of a memoized call, kept along with its result: different
+ * arguments may share the same hash, so they are compared on every hit
+ */
+class MemoKey {
+ public:
+  // Destructor
+  virtual ~MemoKey() {}
+
+  // Purely virtual methods
+  virtual std::size_t hash() const = 0;
+  virtual bool equals(const MemoKey &other) const = 0;
+  virtual std::unique_ptr<MemoKey> clone() const = 0;
+
+  // Static methods
+  static std::size_t mix(std::size_t seed, std::size_t value) {
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+  }
+};
+
+/* CLASS MemoArgs *************************************************************/
+
+/**
+ * @class MemoArgs
+ * Copy of memoizable arguments (see memoizable)
+ */
+template<typename... Args>
+class MemoArgs : public MemoKey {
+ public:
+  // Constructors
+  explicit MemoArgs(const Args&... args)
+      : _args(args...) {
+  }
+
+  // Overriden methods
+  std::size_t hash() const override {
+    return hash(std::index_sequence_for<Args...>{});
+  }
+
+  bool equals(const MemoKey &other) const override {
+    if (typeid(other) != typeid(MemoArgs)) return false;
+    return equals(static_cast<const MemoArgs &>(other)._args,
+                  std::index_sequence_for<Args...>{});
+  }
+
+  std::unique_ptr<MemoKey> clone() const override {
+    return std::unique_ptr<MemoKey>(new MemoArgs(*this));
+  }
+
+ private:
+  // Instance variables
+  std::tuple<Args...> _args;
+
+  // Static methods
+  template<typename Arg>
+  static std::size_t hash(const Arg &/* arg */, std::true_type /* empty */) {
+    return 0;
+  }
+
+  template<typename Arg>
+  static std::size_t hash(const Arg &arg, std::false_type /* empty */) {
+    return std::hash<Arg>{}(arg);
+  }
+
+  template<typename Arg>
+  static bool equal(const Arg &/* lhs */, const Arg &/* rhs */,
+                    std::true_type /* empty */) {
+    return true;
+  }
+
+  template<typename Arg>
+  static bool equal(const Arg &lhs, const Arg &rhs,
+                    std::false_type /* empty */) {
+    return lhs == rhs;
+  }
+
+  // Concrete methods
+  template<std::size_t... I>
+  std::size_t hash(std::index_sequence<I...>) const {
+    std::size_t seed = typeid(MemoArgs).hash_code();
+    using expand = int[];
+    (void) expand{ 0, (seed = mix(seed, hash(std::get<I>(_args),
+                                            std::is_empty<Args>{})), 0)... };
+    return seed;
+  }
+
+  template<std::size_t... I>
+  bool equals(const std::tuple<Args...> &other,
+              std::index_sequence<I...>) const {
+    bool same = true;
+    using expand = int[];
+    (void) expand{ 0, (same = same && equal(std::get<I>(_args),
+                                            std::get<I>(other),
+                                            std::is_empty<Args>{}), 0)... };
+    return same;
+  }
+};
+
+/* CLASS Creator **************************************************************/
+
+// Forward declaration
+template<typename T, typename M>
+class Creator;
+
+// Alias
+template<typename T, typename M>
+using CreatorPtr = std::shared_ptr<Creator<T, M>>;
+
+/**
+ * @class Creator
+ * Interface for implementation of Creator front-end
+ */
+template<typename T, typename M>
+class Creator : public std::enable_shared_from_this<Creator<T, M>> {
+ public:
+  // Alias
+  using Base = void;
+  using MPtr = std::shared_ptr<M>;
+
+  // Purely virtual methods
+  virtual const WordStore& words() const = 0;
+  virtual void add_word(const std::string& word) = 0;
+  virtual void add_word(Span<char> word) = 0;
+
+  // Concrete methods
+
+  // Models of memoizing creators (see CachedCreator) may be shared with
+  // other callers, which must then treat them as immutable
+  template<typename... Args>
+  MPtr create(Args&&... args) const {
+    TraceSpan span("Creator::create");
+
+    if (sizeof...(Args) > 0 && memoizing()) {
+      return memoize(memoizable<std::decay_t<Args>...>{},
+                     std::forward<Args>(args)...);
+    }
+
+    CALL_STATIC_MEMBER_FUNCTION_DELEGATOR(create, std::forward<Args>(args)...);
+  }
+
+  // Copy of the words as strings, for callers of the former
+  // std::vector<std::string> words() (words are only appended by add_word)
+  std::vector<std::string> word_list() const {
+    const WordStore &store = words();
+    return std::vector<std::string>(store.begin(), store.end());
+  }
+
+  // Virtual methods
+  virtual bool memoizing() const {
+    return false;
+  }
+
+  // Adds this creator, and the ones it reaches (such as the creators of
+  // states given as parameters), to the given list
+  virtual void reach(std::vector<const void *> &creators) const {
+    creators.push_back(this);
+  }
+
+  // Adds the number of words of this creator, and of the ones it reaches, to
+  // the given list: words are only appended, so the list changes whenever
+  // any of them receives a word
+  virtual void count_words(std::vector<std::size_t> &counts) const {
+    counts.push_back(words().size());
+  }
+
+ protected:
+  // Purely virtual methods
+  virtual bool delegate() const = 0;
+  virtual MPtr createAlt() const = 0;
+
+  // Virtual methods
+  virtual MPtr memoized(const MemoKey &/* key */,
+                        const std::function<MPtr()> &build) const {
+    return build();
+  }
+
+  GENERATE_STATIC_MEMBER_FUNCTION_DELEGATOR(create, M)
+
+ private:
+  // Concrete methods
+  template<typename... Args>
+  MPtr memoize(std::true_type /* memoizable */, Args&&... args) const {
+    MemoArgs<std::decay_t<Args>...> key(args...);
+    return memoized(key, [&] {
+      return this->createImpl(std::forward<Args>(args)...);
+    });
+  }
+
+  template<typename... Args>
+  MPtr memoize(std::false_type /* memoizable */, Args&&... args) const {
+    return this->createImpl(std::forward<Args>(args)...);
+  }
+};
+
+/* FUNCTION delegate_create ***************************************************/
+
+// Calls M::create directly (as the static delegator of Creator would),
+// borrowing the creator when M has an overload taking it by const reference
+
+template<typename T, typename M, typename... Args>
+auto delegate_create(delegate_borrowed_tag, const Creator<T, M> *creator,
+                     Args&&... args)
+    -> decltype(M::create(borrow(creator), std::forward<Args>(args)...)) {
+  return M::create(borrow(creator), std::forward<Args>(args)...);
+}
+
+template<typename T, typename M, typename... Args>
+auto delegate_create(delegate_shared_tag, const Creator<T, M> *creator,
+                     Args&&... args)
+    -> decltype(M::create(CreatorPtr<T, M>(), std::forward<Args>(args)...)) {
+  return M::create(const_cast<Creator<T, M> *>(creator)->shared_from_this(),
+                   std::forward<Args>(args)...);
+}
+
+/* CLASS SimpleCreator ********************************************************/
+
+// Forward declaration
+template<typename T, typename M>
+class SimpleCreator;
+
+// Alias
+template<typename T, typename M>
+using SimpleCreatorPtr = std::shared_ptr<SimpleCreator<T, M>>;
+
+/**
+ * @class SimpleCreator
+ * Simple implementation of Creator front-end
+ */
+template<typename T, typename M>
+class SimpleCreator : public Creator<T, M> {
+ public:
+  // Alias
+  using Base = Creator<T, M>;
+  using MPtr = std::shared_ptr<M>;
+
+  using Self = SimpleCreator<T, M>;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return SelfPtr(new Self(std::forward<Args>(args)...));
+  }
+
+  template<typename Alloc, typename... Args>
+  static SelfPtr make(std::allocator_arg_t, Alloc &&alloc, Args&&... args) {
+    return make_allocated<Self>(alloc, std::forward<Args>(args)...);
+  }
+
+  // Overriden methods
+  const WordStore& words() const override {
+    return _words;
+  }
+
+  void add_word(const std::string &word) override {
+    _words.add(word);
+  }
+
+  void add_word(Span<char> word) override {
+    _words.add(word);
+  }
+
+  // Concrete methods
+  void interning(bool enabled) {
+    _words.interning(enabled);
+  }
+
+ protected:
+  // Instance variables
+  mutable WordStore _words;  // Filled when first read by StreamingCreator
+
+  // Overriden methods
+  bool delegate() const override {
+    return true;
+  }
+
+  MPtr createAlt() const override {
+    throw std::logic_error("Cannot create M without parameters");
+  }
+};
+
+/* CLASS CachedCreator ********************************************************/
+
+// Forward declaration
+template<typename T, typename M, typename... Params>
+class CachedCreator;
+
+// Alias
+template<typename T, typename M, typename... Params>
+using CachedCreatorPtr = std::shared_ptr<CachedCreator<T, M, Params...>>;
+
+/**
+ * @class CachedCreator
+ * Cached implementation of Creator front-end. When memoizing, each model
+ * created is shared by further calls with the same words and arguments (or
+ * stored parameters). Models are built without holding the memo, so
+ * concurrent calls may build the same one more than once, but all of them
+ * share the first one stored. Calls with arguments that are not memoizable
+ * (see memoizable) are not memoized. At most `capacity` models are kept:
+ * past it, the memo starts over. Memoized models are kept only while the
+ * words of this creator, and of the creators it reaches, stay the same:
+ * they are counted with the memo locked (add_word locks it too), and a
+ * model built while words were added is not stored. Words must still not
+ * be added while creating, as models read them unlocked.
+ *
+ * Memoized models are still handed out as `std::shared_ptr<M>`, as their
+ * front-ends and acceptors are reached through non-const methods, but they
+ * are shared: callers must treat them as immutable.
+ */
+template<typename T, typename M, typename... Params>
+class CachedCreator : public SimpleCreator<T, M> {
+ public:
+  // Alias
+  using Base = SimpleCreator<T, M>;
+  using MPtr = std::shared_ptr<M>;
+
+  using Self = CachedCreator<T, M, Params...>;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return SelfPtr(new Self(std::forward<Args>(args)...));
+  }
+
+  template<typename Alloc, typename... Args>
+  static SelfPtr make(std::allocator_arg_t, Alloc &&alloc, Args&&... args) {
+    return make_allocated<Self>(alloc, std::forward<Args>(args)...);
+  }
+
+  // Overriden methods
+  bool memoizing() const override {
+    return _memoizing.load(std::memory_order_relaxed);
+  }
+
+  void add_word(const std::string &word) override {
+    std::lock_guard<std::mutex> lock(_memo_mutex);
+    Base::add_word(word);
+  }
+
+  void add_word(Span<char> word) override {
+    std::lock_guard<std::mutex> lock(_memo_mutex);
+    Base::add_word(word);
+  }
+
+  void reach(std::vector<const void *> &creators) const override {
+    Base::reach(creators);
+    reachParams([&creators](const auto &creator) {
+      creator.reach(creators);
+    }, std::index_sequence_for<Params...>{});
+  }
+
+  void count_words(std::vector<std::size_t> &counts) const override {
+    std::lock_guard<std::mutex> lock(_memo_mutex);
+    countWords(counts);
+  }
+
+  // Concrete methods
+  const std::tuple<Params...> &params() const {
+    return _params;
+  }
+
+  void memoizing(bool enabled, std::size_t capacity = 1024) {
+    std::lock_guard<std::mutex> lock(_memo_mutex);
+    _memoizing.store(enabled, std::memory_order_relaxed);
+    _memo_capacity = std::max<std::size_t>(capacity, 1);
+    _memo.clear();
+  }
+
+ protected:
+  // Instance variables
+  std::tuple<Params...> _params;
+
+  // Constructors
+  CachedCreator(Params&&... params)
+    : _params(std::forward<Params>(params)...) {
+  }
+
+  // Overriden methods
+  // Stored parameters are keyed as no arguments at all
+  MPtr createAlt() const override {
+    if (!memoizing() || !memoizable<std::decay_t<Params>...>::value)
+      return build();
+    return memoized(MemoArgs<>(), [this] { return build(); });
+  }
+
+  MPtr memoized(const MemoKey &key,
+                const std::function<MPtr()> &build) const override {
+    std::size_t hash = key.hash();
+    std::vector<std::size_t> counts;
+    {
+      std::lock_guard<std::mutex> lock(_memo_mutex);
+      countWords(counts);
+      if (MPtr model = lookup(key, hash, counts)) return model;
+    }
+
+    // Built unlocked, so that M::create may call this creator again
+    MPtr model = build();
+
+    std::lock_guard<std::mutex> lock(_memo_mutex);
+    std::vector<std::size_t> built_counts;
+    countWords(built_counts);
+    if (built_counts != counts) return model;
+    if (MPtr stored = lookup(key, hash, counts)) return stored;
+    if (_memo.size() >= _memo_capacity) _memo.clear();
+    _memo.emplace(hash, std::make_pair(key.clone(), model));
+    return model;
+  }
+
+ private:
+  // Instance variables
+  std::atomic<bool> _memoizing { false };
+
+  mutable std::mutex _memo_mutex;
+  mutable std::unordered_multimap<
+    std::size_t, std::pair<std::unique_ptr<MemoKey>, MPtr>> _memo;
+  std::size_t _memo_capacity = 1024;
+  mutable std::vector<std::size_t> _memo_counts;
+
+  // Static methods
+
+  // Calls func with each creator given as a parameter
+  template<typename Param, typename Func>
+  static void reachParam(const Param &/* param */, Func &/* func */) {
+  }
+
+  template<typename C, typename Func>
+  static auto reachParam(const std::shared_ptr<C> &creator, Func &func)
+      -> decltype(creator->count_words(
+           std::declval<std::vector<std::size_t>&>())) {
+    if (creator) func(*creator);
+  }
+
+  template<typename Param, typename Alloc, typename Func>
+  static void reachParam(const std::vector<Param, Alloc> &params,
+                         Func &func) {
+    for (const auto &param : params) reachParam(param, func);
+  }
+
+  // Concrete methods
+  template<typename Func, std::size_t... I>
+  void reachParams(Func func, std::index_sequence<I...>) const {
+    using expand = int[];
+    (void) expand{ 0, (reachParam(std::get<I>(_params), func), 0)... };
+  }
+
+  // Called with the memo locked (creators reached lock their own)
+  void countWords(std::vector<std::size_t> &counts) const {
+    counts.push_back(this->words().size());
+    reachParams([&counts](const auto &creator) {
+      creator.count_words(counts);
+    }, std::index_sequence_for<Params...>{});
+  }
+
+  // Words are only appended, so the models memoized are kept only while
+  // the numbers of words stay the same (called with the memo locked)
+  MPtr lookup(const MemoKey &key, std::size_t hash,
+              const std::vector<std::size_t> &counts) const {
+    if (counts != _memo_counts) {
+      _memo.clear();
+      _memo_counts = counts;
+    }
+
+    auto range = _memo.equal_range(hash);
+    for (auto entry = range.first; entry != range.second; ++entry) {
+      if (entry->second.first->equals(key)) return entry->second.second;
+    }
+    return nullptr;
+  }
+
+  MPtr build() const {
+    const Creator<T, M> *creator = this;
+
+    auto func = [](auto&&... args) {
+      return delegate_create(delegate_borrowed_tag{},
+                             std::forward<decltype(args)>(args)...);
+    };
+
+    return call(func, creator, _params);
+  }
+
+  // Friends
+  friend struct allocated_access;
+};
+
+/* CLASS StreamingCreator *****************************************************/
+
+// Forward declaration
+template<typename T, typename M, typename... Params>
+class StreamingCreator;
+
+// Alias
+template<typename T, typename M, typename... Params>
+using StreamingCreatorPtr
+  = std::shared_ptr<StreamingCreator<T, M, Params...>>;
+
+/**
+ * @class StreamingCreator
+ * Cached implementation of Creator front-end whose words, separated by
+ * whitespace, are read from a source in chunks. Words may be pulled chunk
+ * by chunk without being kept, so corpora larger than memory can be
+ * processed incrementally. Otherwise, the words are read when first
+ * required, and split straight into the word store, which only keeps a
+ * dictionary and 4-byte ids per word when interning (models built from
+ * words() need the whole corpus in memory). Words are read only once, even
+ * by concurrent calls. Once words are pulled, words() (and so create)
+ * throws, as models would only see the rest of the corpus.
+ */
+template<typename T, typename M, typename... Params>
+class StreamingCreator : public CachedCreator<T, M, Params...> {
+ public:
+  // Alias
+  using Base = CachedCreator<T, M, Params...>;
+  using MPtr = std::shared_ptr<M>;
+
+  using Self = StreamingCreator<T, M, Params...>;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return SelfPtr(new Self(std::forward<Args>(args)...));
+  }
+
+  // Overriden methods
+  const WordStore& words() const override {
+    load();
+    return Base::words();
+  }
+
+  // Concrete methods
+  void load() const {
+    std::call_once(_loaded, [this] {
+      std::lock_guard<std::mutex> lock(_source_mutex);
+      if (_pulled)
+        throw std::logic_error("Cannot load the words of a pulled source");
+      auto add = [this](Span<char> word) { this->_words.add(word); };
+      while (read(add)) {}
+    });
+  }
+
+  // Gives the words of the next chunk of the source to consume, valid only
+  // during the call, without keeping them (words() throws afterwards).
+  // Returns false once the source is exhausted
+  template<typename Consumer>
+  bool pull(Consumer consume) {
+    std::lock_guard<std::mutex> lock(_source_mutex);
+    _pulled = true;
+    return read(consume);
+  }
+
+ protected:
+  // Instance variables
+  mutable WordSourcePtr _source;
+  mutable std::string _partial;
+  mutable std::mutex _source_mutex;
+  mutable std::once_flag _loaded;
+  bool _pulled = false;
+
+  // Constructors
+  StreamingCreator(WordSourcePtr source, Params&&... params)
+    : Base(std::forward<Params>(params)...), _source(std::move(source)) {
+  }
+
+ private:
+  // Static methods
+  static bool separator(char c) {
+    return c == ' ' || c == '\n' || c == '\t'
+        || c == '\r' || c == '\v' || c == '\f';
+  }
+
+  // Concrete methods
+
+  // Called with the source locked
+  template<typename Consumer>
+  bool read(Consumer &consume) const {
+    if (!_source) return false;
+
+    Span<char> chunk;
+    if (!_source->read(chunk)) {
+      if (!_partial.empty())
+        consume(Span<char>(_partial.data(), _partial.size()));
+      _partial.clear();
+      _source = nullptr;
+      return false;
+    }
+
+    const char *word = chunk.begin();
+    for (const char *c = chunk.begin(); c != chunk.end(); c++) {
+      if (!separator(*c)) continue;
+      split(word, c, consume);
+      word = c + 1;
+    }
+    _partial.append(word, chunk.end() - word);  // Continues in next chunk
+    return true;
+  }
+
+  template<typename Consumer>
+  void split(const char *begin, const char *end, Consumer &consume) const {
+    if (!_partial.empty()) {
+      _partial.append(begin, end - begin);
+      consume(Span<char>(_partial.data(), _partial.size()));
+      _partial.clear();
+    } else if (begin != end) {
+      consume(Span<char>(begin, end - begin));
+    }
+  }
+
+  // Friends
+  friend struct allocated_access;
+};
+
+/* CLASS FixedCreator *********************************************************/
+
+/**
+ * @class FixedCreator
+ * Fixed implementation of Creator front-end, creating copies of a predefined
+ * model. Copies share its const text and list of states (pointing to the
+ * same state models) and start with front-ends of their own: a shallow
+ * copy, never copied on write
+ */
+template<typename T, typename M>
+class FixedCreator : public Creator<T, M> {
+ public:
+  // Alias
+  using Base = Creator<T, M>;
+  using MPtr = std::shared_ptr<M>;
+
+  using Self = FixedCreator;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return SelfPtr(new Self(std::forward<Args>(args)...));
+  }
+
+  template<typename Alloc, typename... Args>
+  static SelfPtr make(std::allocator_arg_t, Alloc &&alloc, Args&&... args) {
+    return make_allocated<Self>(alloc, std::forward<Args>(args)...);
+  }
+
+  // Overriden methods
+  const WordStore& words() const override {
+    throw std::logic_error("Should not be called");
+  }
+
+  void add_word(const std::string& /* word */) override {
+    /* do nothing */
+  }
+
+  void add_word(Span<char> /* word */) override {
+    /* do nothing */
+  }
+
+ protected:
+  // Instance variables
+  MPtr _m;
+
+  // Constructors
+  FixedCreator(MPtr m) : _m(std::move(m)) {
+  }
+
+  // Overriden methods
+  bool delegate() const override {
+    return false;
+  }
+
+  MPtr createAlt() const override {
+    return M::make(*(_m.get()));
+  }
+
+  // Friends
+  friend struct allocated_access;
+};
+
+/* CLASS StaticCreator ********************************************************/
+
+// Strategies of StaticCreator, matching SimpleCreator, CachedCreator and
+// FixedCreator respectively
+struct simple_strategy {};
+
+template<typename... Params>
+struct cached_strategy {};
+
+struct fixed_strategy {};
+
+/**
+ * @class StaticCreator
+ * Statically typed facade of a Creator whose strategy is chosen at compile
+ * time, so `create` calls M::create (or M::make) directly, without the
+ * virtual calls of the delegator (see delegate_create). The underlying
+ * polymorphic creator stays available for runtime configuration.
+ */
+template<typename T, typename M, typename Strategy>
+class StaticCreator;
+
+template<typename T, typename M>
+class StaticCreator<T, M, simple_strategy> {
+ public:
+  // Alias
+  using MPtr = std::shared_ptr<M>;
+
+  // Constructors
+  StaticCreator()
+      : _creator(SimpleCreator<T, M>::make()) {
+  }
+
+  // Concrete methods
+  template<typename... Args>
+  MPtr create(Args&&... args) const {
+    return delegate_create(delegate_borrowed_tag{}, _creator.get(),
+                           std::forward<Args>(args)...);
+  }
+
+  void add_word(const std::string &word) {
+    _creator->add_word(word);
+  }
+
+  const CreatorPtr<T, M> &creator() const {
+    return _creator;
+  }
+
+ private:
+  // Instance variables
+  CreatorPtr<T, M> _creator;
+};
+
+template<typename T, typename M, typename... Params>
+class StaticCreator<T, M, cached_strategy<Params...>> {
+ public:
+  // Alias
+  using MPtr = std::shared_ptr<M>;
+
+  // Constructors
+  explicit StaticCreator(Params... params)
+      : _cached(CachedCreator<T, M, Params...>::make(std::move(params)...)),
+        _creator(_cached) {
+  }
+
+  // Concrete methods
+  MPtr create() const {
+    const Creator<T, M> *creator = _creator.get();
+    auto func = [](auto&&... args) {
+      return delegate_create(delegate_borrowed_tag{},
+                             std::forward<decltype(args)>(args)...);
+    };
+    return call(func, creator, _cached->params());
+  }
+
+  void add_word(const std::string &word) {
+    _creator->add_word(word);
+  }
+
+  const CreatorPtr<T, M> &creator() const {
+    return _creator;
+  }
+
+ private:
+  // Instance variables
+  CachedCreatorPtr<T, M, Params...> _cached;
+  CreatorPtr<T, M> _creator;
+};
+
+template<typename T, typename M>
+class StaticCreator<T, M, fixed_strategy> {
+ public:
+  // Alias
+  using MPtr = std::shared_ptr<M>;
+
+  // Constructors
+  explicit StaticCreator(MPtr m)
+      : _m(std::move(m)), _creator(FixedCreator<T, M>::make(_m)) {
+  }
+
+  // Concrete methods
+  MPtr create() const {
+    return M::make(*_m);
+  }
+
+  const CreatorPtr<T, M> &creator() const {
+    return _creator;
+  }
+
+ private:
+  // Instance variables
+  MPtr _m;
+  CreatorPtr<T, M> _creator;
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                               HIERARCHY BACK-END
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* CLASS Top ******************************************************************/
+
+// Forward declaration
+class Top;
+
+// Alias
+using TopPtr = std::shared_ptr<Top>;
+
+/**
+ * @class Top
+ * Top of the class hierarchy
+ */
+class Top {
+ public:
+  // Destructor
+  virtual ~Top() {}
+
+  // Purely virtual methods
+  virtual AcceptorPtr acceptor(VisitorPtr visitor) = 0;
+  virtual void dump(Sink &sink) = 0;
+
+  // Concrete methods
+  void dump() {
+    dump(*StreamSink::standard());
+  }
+};
+
+/* CLASS TopCrtp **************************************************************/
+
+// Forward declaration
+template<typename Derived, typename HandlePolicy = shared_handles>
+class TopCrtp;
+
+// Alias
+template<typename Derived, typename HandlePolicy = shared_handles>
+using TopCrtpPtr = std::shared_ptr<TopCrtp<Derived, HandlePolicy>>;
+
+/**
+ * @class TopCrtp
+ * Implementation of visitor, using CRTP to inject methods in subclasses.
+ * Acceptors and front-ends are given to the model (and the model to them)
+ * with handles of the given policy (see shared_handles)
+ */
+template<typename Derived, typename HandlePolicy>
+class TopCrtp
+    : public HandlePolicy::template shareable<TopCrtp<Derived, HandlePolicy>>,
+      public virtual Top,
+      public HandlePolicy::counted {
+ public:
+  // Alias
+  using Base = void;
+  using Cache = std::conditional_t<HandlePolicy::thread_safe::value,
+                                   ConcurrentMemoTable<std::string, int>,
+                                   MemoTable<std::string, int>>;
+  using DerivedPtr = std::shared_ptr<Derived>;
+  using Handles = HandlePolicy;
+
+  template<typename T>
+  using Handle = typename Handles::template handle<T>;
+
+  // Static methods
+
+  // Models counted intrusively are owned only through their handle policy,
+  // so their constructors have to be protected (reached by allocated_access)
+  template<typename... Args>
+  static DerivedPtr make(Args&&... args) {
+    static_assert(!std::is_constructible<Derived, Args&&...>::value,
+                  "Models built by make need protected constructors");
+    return Handles::own(
+      allocated_access::create<Derived>(std::forward<Args>(args)...));
+  }
+
+  static CreatorPtr<Target, Derived> targetCreator() {
+    return SimpleCreator<Target, Derived>::make();
+  }
+
+  static CreatorPtr<Target, Derived> targetCreator(DerivedPtr model) {
+    return FixedCreator<Target, Derived>::make(model);
+  }
+
+  template<typename Tag, typename... Args>
+  static CreatorPtr<Target, Derived> targetCreator(Tag, Args&&... args) {
+    return CachedCreator<Target, Derived, Tag, Args...>::make(
+      Tag{}, std::forward<Args>(args)...);
+  }
+
+  template<typename Source, typename Tag, typename... Args>
+  static CreatorPtr<Target, Derived> targetCreator(
+      std::shared_ptr<Source> source, Tag, Args&&... args) {
+    return StreamingCreator<Target, Derived, Tag, Args...>::make(
+      std::move(source), Tag{}, std::forward<Args>(args)...);
+  }
+
+  static CreatorPtr<Spot, Derived> spotCreator() {
+    return SimpleCreator<Spot, Derived>::make();
+  }
+
+  static CreatorPtr<Target, Derived> spotCreator(DerivedPtr model) {
+    return FixedCreator<Target, Derived>::make(model);
+  }
+
+  template<typename Tag, typename... Args>
+  static CreatorPtr<Spot, Derived> spotCreator(Tag, Args&&... args) {
+    return CachedCreator<Spot, Derived, Tag, Args...>::make(
+      Tag{}, std::forward<Args>(args)...);
+  }
+
+  template<typename Source, typename Tag, typename... Args>
+  static CreatorPtr<Spot, Derived> spotCreator(
+      std::shared_ptr<Source> source, Tag, Args&&... args) {
+    return StreamingCreator<Spot, Derived, Tag, Args...>::make(
+      std::move(source), Tag{}, std::forward<Args>(args)...);
+  }
+
+  // Overriden methods
+  AcceptorPtr acceptor(VisitorPtr visitor) override {
+    return Handles::template make<SimpleAcceptor<Derived>>(handle(), visitor);
+  }
+
+  using Top::dump;
+
+  void dump(Sink &sink) override {
+    _text.segments([&sink](Span<char> segment) { sink.write(segment); });
+    sink.write(Span<char>("\n", 1));
+  }
+
+  // Concrete methods
+  const std::string &text() const {
+    return _text.str();
+  }
+
+  const WordRope &rope() const {
+    return _text;
+  }
+
+  Handle<Derived> handle() {
+    return Handles::from(static_cast<Derived *>(this));
+  }
+
+  // Virtual methods
+  virtual void accept(Handle<SimpleAcceptor<Derived>> acceptor,
+                      const Acceptor::traversal& /* type */) {
+    visit(*acceptor->visitor(), this->make_shared(), 0);
+  }
+
+  virtual void accept(Handle<SimpleAcceptor<Derived>> acceptor,
+                      const Acceptor::traversal& type,
+                      WorkStealingPool &/* pool */,
+                      std::size_t /* cutoff */) {
+    accept(acceptor, type);
+  }
+
+ protected:
+  // Instance variables
+  WordRope _text;
+
+  // Static methods
+  static WordRope buildMessage(const WordStore &words,
+                               const std::string &divisor) {
+    return WordRope(words, divisor);
+  }
+
+  // Models unknown to Visitor have to override accept to be visited
+  template<typename M>
+  static auto visit(Visitor &visitor, std::shared_ptr<M> model, int)
+      -> decltype(visitor.visit(model)) {
+    visitor.visit(std::move(model));
+  }
+
+  template<typename M>
+  static void visit(Visitor &/* visitor */, std::shared_ptr<M> /* model */,
+                    long) {
+    throw std::logic_error("Cannot visit a model unknown to Visitor");
+  }
+
+  // Constructors
+  TopCrtp(WordRope text = {})
+    : _text(std::move(text)) {
+  }
+
+  template<typename Alloc, typename Text>
+  TopCrtp(std::allocator_arg_t, const Alloc &alloc, Text &&text)
+    : _text(std::allocator_arg, alloc, std::forward<Text>(text)) {
+  }
+
+  // Concrete methods
+  // Only for the interfaces taking a std::shared_ptr (see shared_handles)
+  DerivedPtr make_shared() {
+    return Handles::share(static_cast<Derived *>(this));
+  }
+
+  // Friends
+  friend struct allocated_access;
+};
+
+/* CLASS Baz ******************************************************************/
+
+// Forward declaration
+class Baz;
+
+// Alias
+using BazPtr = std::shared_ptr<Baz>;
+
+/**
+ * @class Baz
+ * Basic son of Top
+ */
+class Baz : public TopCrtp<Baz> {
+ public:
+  // Alias
+  using Base = TopCrtp<Baz>;
+
+  using Self = Baz;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return Handles::own(
+      allocated_access::create<Self>(std::forward<Args>(args)...));
+  }
+
+  // Model, text and states taken from the allocator
+  template<typename Alloc, typename... Args>
+  static SelfPtr make(std::allocator_arg_t, Alloc &&alloc, Args&&... args) {
+    return make_allocated<Self>(
+      alloc, std::allocator_arg, alloc, std::forward<Args>(args)...);
+  }
+
+  static SelfPtr create(const Creator<Target, Self> &creator,
+                        creator_newline_tag) {
+    return Self::make(buildMessage(creator.words(), "\n"));
+  }
+
+  static SelfPtr create(const Creator<Target, Self> &creator,
+                        creator_space_tag) {
+    return Self::make(buildMessage(creator.words(), " "));
+  }
+
+ protected:
+  // Constructor inheritance
+  using Base::TopCrtp;
+
+  // Friends
+  friend struct allocated_access;
+};
+
+/* CLASS Bar ******************************************************************/
+
+// Forward declaration
+class Bar;
+
+// Alias
+using BarPtr = std::shared_ptr<Bar>;
+
+/**
+ * @class Bar
+ * Complex son of Top, with definition of new front-end
+ */
+class Bar : public virtual Top {
+ public:
+  // Destructor
+  virtual ~Bar() {}
+
+  // Purely virtual methods
+  virtual FooPtr<Target> targetFoo(bool cached) = 0;
+  virtual FooPtr<Spot> spotFoo(bool cached) = 0;
+};
+
+/* CLASS BarCrtp **************************************************************/
+
+// Forward declaration
+template<typename Derived, typename HandlePolicy = shared_handles>
+class BarCrtp;
+
+// Alias
+template<typename Derived, typename HandlePolicy = shared_handles>
+using BarCrtpPtr = std::shared_ptr<BarCrtp<Derived, HandlePolicy>>;
+
+/**
+ * @class BarCrtp
+ * Implementation of front-end, using CRTP to inject methods in subclasses
+ */
+template<typename Derived, typename HandlePolicy>
+class BarCrtp : public TopCrtp<Derived, HandlePolicy>, public virtual Bar {
+ public:
+  // Alias
+  using Base = TopCrtp<Derived, HandlePolicy>;
+
+  template<typename T>
+  using Handle = typename Base::template Handle<T>;
+
+  // Overriding methods
+  FooPtr<Target> targetFoo(bool cached = true) override {
+    if (cached)
+      return _cached_target_foo.get(this->make_shared());
+    return _simple_target_foo.get(this->make_shared());
+  }
+
+  FooPtr<Spot> spotFoo(bool cached = true) override {
+    if (cached)
+      return _cached_spot_foo.get(this->make_shared());
+    return _simple_spot_foo.get(this->make_shared());
+  }
+
+  void messageBroadcast(const std::string& msg) const {
+    if (!msg.empty())
+      std::cout << "Transmiting message: " << msg << std::endl;
+  }
+
+  // Information content of the message, in bits: its length times the
+  // entropy of its bytes (worth memoizing for long messages)
+  auto messageWeight(const std::string& msg) const {
+    using Weight = typename Derived::Cache::mapped_type;
+
+    std::size_t counts[256] = {};
+    for (unsigned char c : msg) counts[c]++;
+
+    double bits = 0.0;
+    for (std::size_t count : counts) {
+      if (count == 0) continue;
+      double p = static_cast<double>(count) / msg.size();
+      bits -= count * std::log2(p);
+    }
+    return static_cast<Weight>(bits);
+  }
+
+  // Virtual methods
+
+  // Front-ends are borrowed (see the member delegator), so the calls made
+  // through them do not touch any reference count
+  virtual void method(const SimpleFoo<Target, Derived> &/* simple_foo */,
+                      const std::string &msg) const {
+    std::cout << "Running simple for Target in BarCrtp" << std::endl;
+    messageBroadcast(msg);
+  }
+
+  virtual void method(const CachedFoo<Target, Derived> &cached_foo,
+                      const std::string &msg) const {
+    std::cout << "Running cached for Target in BarCrtp" << std::endl;
+    auto weight = cached_foo.memoize(msg, [&] {
+      return messageWeight(msg);
+    });
+    std::cout << "Cache: " << typeid(weight).name() << std::endl;
+    messageBroadcast(msg);
+  }
+
+  virtual void method(const SimpleFoo<Spot, Derived> &/* simple_foo */,
+                      const std::string &msg) const {
+    std::cout << "Running simple for Spot in BarCrtp" << std::endl;
+    messageBroadcast(msg);
+  }
+
+  virtual void method(const CachedFoo<Spot, Derived> &cached_foo,
+                      const std::string &msg) const {
+    std::cout << "Running cached for Spot in BarCrtp" << std::endl;
+    auto weight = cached_foo.memoize(msg, [&] {
+      return messageWeight(msg);
+    });
+    std::cout << "Cache: " << typeid(weight).name() << std::endl;
+    messageBroadcast(msg);
+  }
+
+  // Batched versions, to be overriden with specialized loops
+  virtual void method(const SimpleFoo<Target, Derived> &simple_foo,
+                      Span<std::string> msgs) const {
+    for (const auto &msg : msgs) method(simple_foo, msg);
+  }
+
+  virtual void method(const CachedFoo<Target, Derived> &cached_foo,
+                      Span<std::string> msgs) const {
+    for (const auto &msg : msgs) method(cached_foo, msg);
+  }
+
+  virtual void method(const SimpleFoo<Spot, Derived> &simple_foo,
+                      Span<std::string> msgs) const {
+    for (const auto &msg : msgs) method(simple_foo, msg);
+  }
+
+  virtual void method(const CachedFoo<Spot, Derived> &cached_foo,
+                      Span<std::string> msgs) const {
+    for (const auto &msg : msgs) method(cached_foo, msg);
+  }
+
+ protected:
+  // Instance variables
+  LazyFrontEnd<SimpleFoo<Target, Derived>> _simple_target_foo;
+  LazyFrontEnd<CachedFoo<Target, Derived>> _cached_target_foo;
+  LazyFrontEnd<SimpleFoo<Spot, Derived>> _simple_spot_foo;
+  LazyFrontEnd<CachedFoo<Spot, Derived>> _cached_spot_foo;
+
+  // Constructor inheritance
+  using Base::TopCrtp;
+
+  // Friends
+  friend struct allocated_access;
+};
+
+/* CLASS BarDerived ***********************************************************/
+
+// Forward declaration
+class BarDerived;
+
+// Alias
+using BarDerivedPtr = std::shared_ptr<BarDerived>;
+
+/**
+ * @class BarDerived
+ * Class "overriding" parent implementation
+ */
+class BarDerived : public BarCrtp<BarDerived> {
+ public:
+  // Alias
+  using Base = BarCrtp<BarDerived>;
+  using Cache = ConcurrentMemoTable<std::string, double>;
+
+  using Self = BarDerived;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  using State = BarDerived;
+  using StatePtr = BarDerivedPtr;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return Handles::own(
+      allocated_access::create<Self>(std::forward<Args>(args)...));
+  }
+
+  // Model, text and states taken from the allocator
+  template<typename Alloc, typename... Args>
+  static SelfPtr make(std::allocator_arg_t, Alloc &&alloc, Args&&... args) {
+    return make_allocated<Self>(
+      alloc, std::allocator_arg, alloc, std::forward<Args>(args)...);
+  }
+
+  static SelfPtr create(
+      const Creator<Target, Self> &creator, creator_carriage_tag,
+      const std::vector<CreatorPtr<Target, State>> &state_creators = {}) {
+    return Self::make(
+      buildMessage(creator.words(), "\r"),
+      initializeStates(state_creators, creator.words())
+    );
+  }
+
+  static SelfPtr create(
+      const Creator<Target, Self> &creator, creator_carriage_tag,
+      const std::vector<CreatorPtr<Target, State>> &state_creators,
+      parallel_policy policy) {
+    return Self::make(
+      buildMessage(creator.words(), "\r"),
+      initializeStates(state_creators, creator.words(), policy)
+    );
+  }
+
+  static SelfPtr create(
+      const Creator<Target, Self> &creator, creator_newline_tag,
+      const std::vector<CreatorPtr<Target, State>> &state_creators = {}) {
+    return Self::make(
+      buildMessage(creator.words(), "\n"),
+      initializeStates(state_creators, creator.words())
+    );
+  }
+
+  static SelfPtr create(
+      const Creator<Target, Self> &creator, creator_newline_tag,
+      const std::vector<CreatorPtr<Target, State>> &state_creators,
+      parallel_policy policy) {
+    return Self::make(
+      buildMessage(creator.words(), "\n"),
+      initializeStates(state_creators, creator.words(), policy)
+    );
+  }
+
+  static SelfPtr create(
+      const Creator<Target, Self> &creator, creator_space_tag,
+      const std::vector<CreatorPtr<Target, State>> &state_creators = {}) {
+    return Self::make(
+      buildMessage(creator.words(), " "),
+      initializeStates(state_creators, creator.words())
+    );
+  }
+
+  static SelfPtr create(
+      const Creator<Target, Self> &creator, creator_space_tag,
+      const std::vector<CreatorPtr<Target, State>> &state_creators,
+      parallel_policy policy) {
+    return Self::make(
+      buildMessage(creator.words(), " "),
+      initializeStates(state_creators, creator.words(), policy)
+    );
+  }
+
+  // Constructors
+  BarDerived(WordRope text = {}, std::vector<StatePtr> states = {})
+      : BarDerived(std::move(text), share(std::move(states))) {
+  }
+
+  template<typename Alloc, typename Text>
+  BarDerived(std::allocator_arg_t, const Alloc &alloc, Text &&text,
+             std::vector<StatePtr> states = {})
+      : BarDerived(
+          WordRope(std::allocator_arg, alloc, std::forward<Text>(text)),
+          share(alloc, std::move(states))) {
+  }
+
+  // Overriden methods
+  void accept(SimpleAcceptorPtr<BarDerived> acceptor,
+              const Acceptor::traversal& type) override {
+    compose_accept(acceptor->visitor(), type);
+  }
+
+  void accept(SimpleAcceptorPtr<BarDerived> acceptor,
+              const Acceptor::traversal& type,
+              WorkStealingPool &pool, std::size_t cutoff) override {
+    const VisitorPtr &visitor = acceptor->visitor();
+    ParallelTraversal traversal { pool, type, cutoff, visitor, {} };
+
+    for (unsigned int i = 0; i < pool.size(); i++) {
+      VisitorPtr worker_visitor
+        = visitor->thread_safe() ? visitor : visitor->clone();
+      if (!worker_visitor) {
+        throw std::logic_error(
+          "Cannot traverse in parallel with a visitor neither thread-safe "
+          "nor clonable");
+      }
+      traversal.worker_visitors.push_back(worker_visitor);
+    }
+
+    parallel_compose_accept(traversal);
+
+    if (!visitor->thread_safe()) {
+      for (const auto &worker_visitor : traversal.worker_visitors)
+        visitor->merge(*worker_visitor);
+    }
+  }
+
+  using Base::method;
+
+  void method(const SimpleFoo<Target, BarDerived> &/* simple_foo */,
+              const std::string &msg) const override {
+    std::cout << "Running simple for Target in BarDerived" << std::endl;
+    messageBroadcast(msg);
+  }
+
+  void method(const CachedFoo<Target, BarDerived> &cached_foo,
+              const std::string &msg) const override {
+    std::cout << "Running cached for Target in BarDerived" << std::endl;
+    auto weight = cached_foo.memoize(msg, [&] {
+      return messageWeight(msg);
+    });
+    std::cout << "Cache: " << typeid(weight).name() << std::endl;
+    messageBroadcast(msg);
+  }
+
+  void method(const SimpleFoo<Spot, BarDerived> &/* simple_foo */,
+              const std::string &msg) const override {
+    std::cout << "Running simple for Spot in BarDerived" << std::endl;
+    messageBroadcast(msg);
+  }
+
+  void method(const CachedFoo<Spot, BarDerived> &cached_foo,
+              const std::string &msg) const override {
+    std::cout << "Running cached for Spot in BarDerived" << std::endl;
+    auto weight = cached_foo.memoize(msg, [&] {
+      return messageWeight(msg);
+    });
+    std::cout << "Cache: " << typeid(weight).name() << std::endl;
+    messageBroadcast(msg);
+  }
+
+  // Virtual methods
+
+  // States of subclasses go through their own accept when traversing a
+  // composite, unless the subclass keeps the accept of BarDerived and
+  // overrides this method to say so
+  virtual bool overrides_accept() const {
+    return typeid(*this) != typeid(BarDerived);
+  }
+
+  // Concrete methods
+  template<typename StaticVisitor>
+  void static_accept(StaticVisitor &&visitor,
+                     const Acceptor::traversal& type
+                       = Acceptor::traversal::post_order) {
+    traverse(type, [&visitor](BarDerived &state) { visitor(state); });
+  }
+
+  Span<StatePtr> states() const {
+    return _states;
+  }
+
+  std::size_t composite_size() const {
+    return _composite_size;
+  }
+
+ private:
+  // Inner structs
+  struct ParallelTraversal {
+    WorkStealingPool &pool;
+    Acceptor::traversal type;
+    std::size_t cutoff;
+    const VisitorPtr &caller_visitor;
+    std::vector<VisitorPtr> worker_visitors;
+
+    const VisitorPtr &visitor() const {
+      int i = pool.index();
+      return i < 0 ? caller_visitor : worker_visitors[i];
+    }
+  };
+
+  // Instance variables
+  Span<StatePtr> _states;                     // Const, shared by copies
+  std::shared_ptr<const void> _states_owner;  // and kept alive by its owner
+  std::size_t _composite_size;
+
+  // Constructors
+  template<typename States>
+  BarDerived(WordRope text, std::shared_ptr<const States> states)
+      : BarCrtp(std::move(text)),
+        _states(states ? Span<StatePtr>(*states) : Span<StatePtr>()),
+        _states_owner(std::move(states)), _composite_size(1) {
+    for (const auto &state : _states)
+      _composite_size += state->_composite_size;
+  }
+
+  // Static methods
+  static std::shared_ptr<const std::vector<StatePtr>> share(
+      std::vector<StatePtr> states) {
+    if (states.empty()) return nullptr;
+    return std::make_shared<const std::vector<StatePtr>>(std::move(states));
+  }
+
+  template<typename Alloc>
+  static auto share(const Alloc &alloc, std::vector<StatePtr> states) {
+    using StateAlloc = typename std::allocator_traits<Alloc>::template
+      rebind_alloc<StatePtr>;
+    using States = std::vector<StatePtr, StateAlloc>;
+    if (states.empty()) return std::shared_ptr<const States>();
+    return std::allocate_shared<const States>(
+      alloc, std::make_move_iterator(states.begin()),
+      std::make_move_iterator(states.end()), StateAlloc(alloc));
+  }
+
+  static std::vector<StatePtr> initializeStates(
+      const std::vector<CreatorPtr<Target, State>> &state_creators,
+      const WordStore &words) {
+    TraceSpan span("BarDerived::initializeStates");
+
+    if (!state_creators.empty()) {
+      unsigned int size = state_creators.size();
+      for (unsigned int i = 0; i < words.size(); i++) {
+        state_creators[i % size]->add_word(words[i]);
+      }
+    }
+
+    std::vector<StatePtr> states;
+    for (const auto &state_creator : state_creators) {
+      states.push_back(state_creator->create());
+    }
+
+    return states;
+  }
+
+  static std::vector<StatePtr> initializeStates(
+      const std::vector<CreatorPtr<Target, State>> &state_creators,
+      const WordStore &words, parallel_policy policy) {
+    TraceSpan span("BarDerived::initializeStates");
+
+    // Creators cannot receive words concurrently if they share a creator
+    // (themselves, or one they reach, like the creators of their states)
+    std::vector<const void *> creators;
+    for (const auto &state_creator : state_creators) {
+      std::vector<const void *> reached;
+      state_creator->reach(reached);
+      std::sort(reached.begin(), reached.end());
+      creators.insert(creators.end(), reached.begin(),
+                      std::unique(reached.begin(), reached.end()));
+    }
+    std::sort(creators.begin(), creators.end());
+    if (state_creators.size() < 2
+        || std::adjacent_find(creators.begin(), creators.end())
+           != creators.end())
+      return initializeStates(state_creators, words);
+
+    // Each state creator receives its words and creates its state in a
+    // task of its own, which stores it in the original position
+    std::size_t size = state_creators.size();
+    std::vector<StatePtr> states(size);
+    auto initialize = [&state_creators, &words, &states, size](std::size_t i) {
+      for (std::size_t j = i; j < words.size(); j += size)
+        state_creators[i]->add_word(words[j]);
+      states[i] = state_creators[i]->create();
+    };
+
+    TaskGroup group(policy.pool);
+    for (std::size_t i = 0; i + 1 < size; i++)
+      group.run([&initialize, i] { initialize(i); });
+    initialize(size - 1);
+    group.wait();
+
+    return states;
+  }
+
+  // Concrete methods
+  void compose_accept(const VisitorPtr &visitor,
+                      const Acceptor::traversal& type) {
+    TraceSpan span("BarDerived::compose_accept");
+    traverse(type, [&visitor](BarDerived &state) {
+      visitor->visit(state.make_shared());
+    }, [&visitor, &type](BarDerived &state) {
+      return state.delegate_accept(visitor, type);
+    });
+  }
+
+  template<typename Function>
+  void traverse(const Acceptor::traversal& type, Function function) {
+    traverse(type, function, [](BarDerived &/* state */) { return false; });
+  }
+
+  template<typename Function, typename Delegate>
+  void traverse(const Acceptor::traversal& type, Function function,
+                Delegate delegate) {
+    // Visits the whole composite with an explicit stack instead of recursion,
+    // reusing the same function for every state (pre_order visits the states
+    // before their composite, post_order visits the composite first). States
+    // for which delegate returns true have already visited their own subtree
+    struct Frame {
+      BarDerived *composite;
+      std::size_t next_state;
+    };
+
+    bool composite_first = (type == Acceptor::traversal::post_order);
+
+    std::vector<Frame> stack;
+    stack.reserve(16);
+
+    if (composite_first) function(*this);
+    stack.push_back({ this, 0 });
+
+    while (!stack.empty()) {
+      Frame &frame = stack.back();
+      if (frame.next_state < frame.composite->_states.size()) {
+        BarDerived *state
+          = frame.composite->_states[frame.next_state++].get();
+        if (delegate(*state)) continue;
+        if (composite_first) function(*state);
+        stack.push_back({ state, 0 });
+      } else {
+        if (!composite_first) function(*frame.composite);
+        stack.pop_back();
+      }
+    }
+  }
+
+  // States of subclasses go through their own (possibly overriden) accept
+  bool delegate_accept(const VisitorPtr &visitor,
+                       const Acceptor::traversal& type) {
+    if (!overrides_accept()) return false;
+    acceptor(visitor)->accept(type);
+    return true;
+  }
+
+  void parallel_compose_accept(const ParallelTraversal &traversal) {
+    TraceSpan span("BarDerived::parallel_compose_accept");
+
+    // Subtrees of different states become tasks, stolen by idle workers
+    if (_composite_size <= traversal.cutoff || _states.empty()) {
+      compose_accept(traversal.visitor(), traversal.type);
+      return;
+    }
+
+    bool composite_first = (traversal.type == Acceptor::traversal::post_order);
+    if (composite_first) traversal.visitor()->visit(this->make_shared());
+
+    TaskGroup group(traversal.pool);
+    for (std::size_t i = 0; i + 1 < _states.size(); i++) {
+      BarDerived *state = _states[i].get();
+      group.run([state, &traversal] {
+        if (!state->delegate_accept(traversal.visitor(), traversal.type))
+          state->parallel_compose_accept(traversal);
+      });
+    }
+    BarDerived *last = _states[_states.size() - 1].get();
+    if (!last->delegate_accept(traversal.visitor(), traversal.type))
+      last->parallel_compose_accept(traversal);
+    group.wait();
+
+    if (!composite_first) traversal.visitor()->visit(this->make_shared());
+  }
+};
+
+/* CLASS BarReusing ***********************************************************/
+
+// Forward declaration
+class BarReusing;
+
+// Alias
+using BarReusingPtr = std::shared_ptr<BarReusing>;
+
+/**
+ * @class BarReusing
+ * Class reusing parent implementation
+ */
+class BarReusing : public BarCrtp<BarReusing> {
+ public:
+  // Alias
+  using Base = BarCrtp<BarReusing>;
+
+  using Self = BarReusing;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return Handles::own(
+      allocated_access::create<Self>(std::forward<Args>(args)...));
+  }
+
+  static SelfPtr create(const Creator<Target, Self> &creator,
+                        creator_newline_tag) {
+    return Self::make(buildMessage(creator.words(), "\r\n"));
+  }
+
+  static SelfPtr create(const Creator<Target, Self> &creator,
+                        creator_tab_tag) {
+    return Self::make(buildMessage(creator.words(), "\t"));
+  }
+
+ protected:
+  // Constructor inheritance
+  using Base::BarCrtp;
+
+  // Friends
+  friend struct allocated_access;
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                 FLAT HIERARCHY
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* CLASS FlatComposite ********************************************************/
+
+/**
+ * @class FlatComposite
+ * BarDerived composite compiled into a contiguous array of nodes, with the
+ * composite before its states (so the subtree of a node is the range that
+ * follows it) and all texts stored in a single buffer
+ */
+class FlatComposite {
+ public:
+  // Inner structs
+  struct Node {
+    std::size_t text_offset;
+    std::size_t text_size;
+    std::size_t end;  // One past the last node of the subtree
+  };
+
+  // Static methods
+  static FlatComposite compile(const BarDerived &composite) {
+    struct Frame {
+      const BarDerived *composite;
+      std::size_t next_state;
+      std::size_t index;
+    };
+
+    FlatComposite flat;
+    flat._nodes.reserve(composite.composite_size());
+
+    std::vector<Frame> stack;
+    stack.push_back({ &composite, 0, flat.push(composite) });
+
+    while (!stack.empty()) {
+      Frame &frame = stack.back();
+      if (frame.next_state < frame.composite->states().size()) {
+        const BarDerived *state
+          = frame.composite->states()[frame.next_state++].get();
+        stack.push_back({ state, 0, flat.push(*state) });
+      } else {
+        flat._nodes[frame.index].end = flat._nodes.size();
+        stack.pop_back();
+      }
+    }
+
+    return flat;
+  }
+
+  // Concrete methods
+  std::size_t size() const {
+    return _nodes.size();
+  }
+
+  const Node &node(std::size_t i) const {
+    return _nodes[i];
+  }
+
+  Span<char> text(const Node &node) const {
+    return Span<char>(_texts.data() + node.text_offset, node.text_size);
+  }
+
+  // Same orders of Acceptor::traversal: pre_order visits the states before
+  // their composite, post_order visits the composite first (a linear scan).
+  // The function receives each node and its text.
+  template<typename Function>
+  void accept(Function function,
+              const Acceptor::traversal& type = Acceptor::traversal::post_order)
+      const {
+    if (type == Acceptor::traversal::post_order) {
+      for (const auto &node : _nodes) function(node, text(node));
+      return;
+    }
+
+    std::vector<std::size_t> composites;
+    for (std::size_t i = 0; i < _nodes.size(); i++) {
+      while (!composites.empty() && _nodes[composites.back()].end <= i) {
+        const Node &composite = _nodes[composites.back()];
+        function(composite, text(composite));
+        composites.pop_back();
+      }
+
+      if (_nodes[i].end > i + 1)
+        composites.push_back(i);
+      else
+        function(_nodes[i], text(_nodes[i]));
+    }
+
+    while (!composites.empty()) {
+      const Node &composite = _nodes[composites.back()];
+      function(composite, text(composite));
+      composites.pop_back();
+    }
+  }
+
+  template<typename Function>
+  void pre_order(Function function) const {
+    accept(function, Acceptor::traversal::pre_order);
+  }
+
+  template<typename Function>
+  void post_order(Function function) const {
+    accept(function, Acceptor::traversal::post_order);
+  }
+
+ private:
+  // Instance variables
+  std::vector<Node> _nodes;
+  std::string _texts;
+
+  // Concrete methods
+  std::size_t push(const BarDerived &composite) {
+    const WordRope &text = composite.rope();
+    _nodes.push_back({ _texts.size(), text.size(), 0 });
+    text.segments([this](Span<char> segment) {
+      _texts.append(segment.begin(), segment.size());
+    });
+    return _nodes.size() - 1;
+  }
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                             STATIC VISITOR FRONT-END
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+// As the hierarchy is closed, visitors may also be plain classes with one
+// (non-virtual) `operator()` for each node type. They are dispatched through
+// a switch on the node kind, so their bodies can be inlined in the traversal.
+// The virtual Visitor remains available for open extension.
+
+/* CLASS TopVariant ***********************************************************/
+
+/**
+ * @class TopVariant
+ * Handle for any node of the closed hierarchy, tagged with its kind
+ */
+class TopVariant {
+ public:
+  // Enum classes
+  enum class kind { baz, bar_derived, bar_reusing };
+
+  // Constructors
+  TopVariant(BazPtr top)
+      : _kind(kind::baz), _node(top.get()), _top(std::move(top)) {
+  }
+
+  TopVariant(BarDerivedPtr top)
+      : _kind(kind::bar_derived), _node(top.get()), _top(std::move(top)) {
+  }
+
+  TopVariant(BarReusingPtr top)
+      : _kind(kind::bar_reusing), _node(top.get()), _top(std::move(top)) {
+  }
+
+  // Concrete methods
+  kind which() const {
+    return _kind;
+  }
+
+  template<typename StaticVisitor>
+  void visit(StaticVisitor &&visitor) const {
+    switch (_kind) {
+      case kind::baz:
+        visitor(*static_cast<Baz *>(_node));
+        break;
+      case kind::bar_derived:
+        visitor(*static_cast<BarDerived *>(_node));
+        break;
+      case kind::bar_reusing:
+        visitor(*static_cast<BarReusing *>(_node));
+        break;
+    }
+  }
+
+  // Composites are fully traversed, other nodes are visited alone
+  template<typename StaticVisitor>
+  void accept(StaticVisitor &&visitor,
+              const Acceptor::traversal& type
+                = Acceptor::traversal::post_order) const {
+    if (_kind == kind::bar_derived)
+      static_cast<BarDerived *>(_node)->static_accept(visitor, type);
+    else
+      visit(visitor);
+  }
+
+ private:
+  // Instance variables
+  kind _kind;
+  void *_node;
+  TopPtr _top;
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                   MODEL IMAGE
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+// Built models can be saved as a binary image, in native byte order:
+//
+//   Header | Record of each node | Links | Texts
+//
+// Records are not in pre-order: the states of a composite are stored next
+// to each other, and the composites among them are expanded last-in,
+// first-out. A composite record holds the range of its states in the
+// links, which are indices of later records, as every composite comes
+// before its states. Loaded models view their texts in the image.
+
+/* CLASS ModelImage ***********************************************************/
+
+/**
+ * @class ModelImage
+ * Saver and loader of binary images of model trees
+ */
+class ModelImage {
+ public:
+  // Static methods
+  static void save(const TopVariant &top, Sink &sink) {
+    Layout layout;
+    top.visit([&layout, &top](const auto &node) {
+      layout.add(top.which(), node);
+    });
+    layout.expand();
+
+    Header header = {
+      { 'T', 'O', 'P', 'S', 'I', 'M', 'G', '\0' }, version, byte_order, 0,
+      layout.records.size(), layout.links.size(), layout.text_size
+    };
+    write(sink, &header, 1);
+    write(sink, layout.records.data(), layout.records.size());
+    write(sink, layout.links.data(), layout.links.size());
+    for (const WordRope *rope : layout.ropes)
+      rope->segments([&sink](Span<char> segment) { sink.write(segment); });
+    sink.flush();
+  }
+
+  static TopVariant load(const std::string &path) {
+    auto mapping = FileMapping::make(path);
+    Span<char> image(static_cast<const char *>(mapping->data()),
+                     mapping->size());
+    return load(image, std::move(mapping));
+  }
+
+  // The owner keeps the image alive for as long as loaded models do
+  static TopVariant load(Span<char> image, std::shared_ptr<const void> owner) {
+    Header header;
+    if (image.size() < sizeof(Header)) malformed();
+    std::memcpy(&header, image.begin(), sizeof(Header));
+    if (std::memcmp(header.magic, "TOPSIMG", 8) != 0
+        || header.version != version || header.byte_order != byte_order
+        || header.nodes == 0)
+      malformed();
+
+    std::uint64_t records = sizeof(Header);
+    std::uint64_t links = records + header.nodes * sizeof(Record);
+    std::uint64_t texts = links + header.links * sizeof(std::uint64_t);
+    if (header.nodes > image.size() / sizeof(Record)
+        || header.links > image.size() / sizeof(std::uint64_t)
+        || texts > image.size() || header.text_size != image.size() - texts)
+      malformed();
+
+    // States follow their composite, so nodes are built backwards
+    std::vector<BarDerivedPtr> composites(header.nodes);
+    for (std::uint64_t i = header.nodes; i-- > 0; ) {
+      Record record;
+      std::memcpy(&record, image.begin() + records + i * sizeof(Record),
+                  sizeof(Record));
+      if (record.text_offset > header.text_size
+          || record.text_size > header.text_size - record.text_offset)
+        malformed();
+
+      WordRope text(Span<char>(image.begin() + texts + record.text_offset,
+                               record.text_size), owner);
+      auto kind = static_cast<TopVariant::kind>(record.kind);
+
+      if (i == 0 && kind == TopVariant::kind::baz)
+        return TopVariant(Baz::make(std::move(text)));
+      if (i == 0 && kind == TopVariant::kind::bar_reusing)
+        return TopVariant(BarReusing::make(std::move(text)));
+      if (kind != TopVariant::kind::bar_derived
+          || record.first_link > header.links
+          || record.states > header.links - record.first_link)
+        malformed();
+
+      std::vector<BarDerivedPtr> states;
+      for (std::uint64_t j = 0; j < record.states; j++) {
+        std::uint64_t link;
+        std::memcpy(&link, image.begin() + links
+                             + (record.first_link + j) * sizeof(link),
+                    sizeof(link));
+        if (link <= i || link >= header.nodes) malformed();
+        states.push_back(composites[link]);
+      }
+      composites[i] = BarDerived::make(std::move(text), states);
+    }
+    return TopVariant(composites[0]);
+  }
+
+ private:
+  // Inner structs
+  struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t reserved;
+    std::uint64_t nodes;
+    std::uint64_t links;
+    std::uint64_t text_size;
+  };
+
+  struct Record {
+    std::uint32_t kind;
+    std::uint32_t states;
+    std::uint64_t first_link;
+    std::uint64_t text_offset;
+    std::uint64_t text_size;
+  };
+
+  struct Layout {
+    std::vector<Record> records;
+    std::vector<std::uint64_t> links;
+    std::vector<const WordRope *> ropes;
+    std::vector<std::pair<const BarDerived *, std::size_t>> pending;
+    std::uint64_t text_size = 0;
+
+    template<typename Node>
+    std::size_t add(TopVariant::kind kind, const Node &node) {
+      const WordRope &rope = node.rope();
+      records.push_back({ static_cast<std::uint32_t>(kind), 0, 0,
+                          text_size, rope.size() });
+      ropes.push_back(&rope);
+      text_size += rope.size();
+      return records.size() - 1;
+    }
+
+    std::size_t add(TopVariant::kind kind, const BarDerived &node) {
+      std::size_t index = add<BarDerived>(kind, node);
+      pending.emplace_back(&node, index);
+      return index;
+    }
+
+    // Composites are expanded with an explicit stack, so deep trees fit
+    void expand() {
+      while (!pending.empty()) {
+        const BarDerived *composite = pending.back().first;
+        Record &record = records[pending.back().second];
+        pending.pop_back();
+
+        if (composite->states().size() > UINT32_MAX)
+          throw std::logic_error("Too many states for a model image");
+        record.first_link = links.size();
+        record.states = static_cast<std::uint32_t>(composite->states().size());
+        for (const auto &state : composite->states())
+          links.push_back(add(TopVariant::kind::bar_derived, *state));
+      }
+    }
+  };
+
+  // Static variables
+  static constexpr std::uint32_t version = 1;
+  static constexpr std::uint32_t byte_order = 0x01020304;
+
+  // Static methods
+  template<typename T>
+  static void write(Sink &sink, const T *data, std::size_t count) {
+    sink.write(Span<char>(reinterpret_cast<const char *>(data),
+                          count * sizeof(T)));
+  }
+
+  [[noreturn]] static void malformed() {
+    throw std::logic_error("Malformed model image");
+  }
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                              VISITOR IMPLEMENTATION
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* CLASS FooVisitor ***********************************************************/
+
+// Forward declaration
+class FooVisitor;
+
+// Alias
+using FooVisitorPtr = std::shared_ptr<FooVisitor>;
+
+/**
+ * @class FooVisitor
+ * Concrete implementation of main hierarchy visitor using Foo front-end
+ */
+class FooVisitor : public Visitor {
+ public:
+  // Static methods
+  template<typename... Args>
+  static FooVisitorPtr make(Args&&... args) {
+    return FooVisitorPtr(new FooVisitor(std::forward<Args>(args)...));
+  }
+
+  // Overriden methods
+  void visit(std::shared_ptr<Baz> /* top */) override {
+  }
+
+  void visit(std::shared_ptr<BarDerived> top) override {
+    top->targetFoo()->method();
+  }
+
+  void visit(std::shared_ptr<BarReusing> top) override {
+    top->targetFoo()->method();
+  }
+};
+
+/* CLASS DumpVisitor **********************************************************/
+
+// Forward declaration
+class DumpVisitor;
+
+// Alias
+using DumpVisitorPtr = std::shared_ptr<DumpVisitor>;
+
+/**
+ * @class DumpVisitor
+ * Concrete implementation of main hierarchy visitor calling method dump
+ */
+class DumpVisitor : public Visitor {
+ public:
+  // Static methods
+  template<typename... Args>
+  static DumpVisitorPtr make(Args&&... args) {
+    return DumpVisitorPtr(new DumpVisitor(std::forward<Args>(args)...));
+  }
+
+  // Overriden methods
+  void visit(std::shared_ptr<Baz> top) override {
+    top->dump(*_sink);
+  }
+
+  void visit(std::shared_ptr<BarDerived> top) override {
+    top->dump(*_sink);
+  }
+
+  void visit(std::shared_ptr<BarReusing> top) override {
+    top->dump(*_sink);
+  }
+
+ protected:
+  // Instance variables
+  SinkPtr _sink;
+
+  // Constructors
+  explicit DumpVisitor(SinkPtr sink = StreamSink::standard())
+      : _sink(std::move(sink)) {
+  }
+};
+
+/* CLASS CountVisitor *********************************************************/
+
+// Forward declaration
+class CountVisitor;
+
+// Alias
+using CountVisitorPtr = std::shared_ptr<CountVisitor>;
+
+/**
+ * @class CountVisitor
+ * Concrete implementation of main hierarchy visitor counting visited nodes,
+ * cloned for each thread in parallel traversals
+ */
+class CountVisitor : public Visitor {
+ public:
+  // Static methods
+  template<typename... Args>
+  static CountVisitorPtr make(Args&&... args) {
+    return CountVisitorPtr(new CountVisitor(std::forward<Args>(args)...));
+  }
+
+  // Overriden methods
+  void visit(std::shared_ptr<Baz> /* top */) override {
+    _count++;
+  }
+
+  void visit(std::shared_ptr<BarDerived> /* top */) override {
+    _count++;
+  }
+
+  void visit(std::shared_ptr<BarReusing> /* top */) override {
+    _count++;
+  }
+
+  VisitorPtr clone() const override {
+    return CountVisitor::make();
+  }
+
+  void merge(const Visitor &clone) override {
+    _count += static_cast<const CountVisitor &>(clone)._count;
+  }
+
+  // Concrete methods
+  std::size_t count() const {
+    return _count;
+  }
+
+ private:
+  // Instance variables
+  std::size_t _count = 0;
+};
+
+/* CLASS StaticFooVisitor *****************************************************/
+
+/**
+ * @class StaticFooVisitor
+ * Static counterpart of FooVisitor, to be used with TopVariant
+ */
+class StaticFooVisitor {
+ public:
+  // Operators
+  void operator()(Baz &/* top */) const {
+  }
+
+  void operator()(BarDerived &top) const {
+    top.targetFoo()->method();
+  }
+
+  void operator()(BarReusing &top) const {
+    top.targetFoo()->method();
+  }
+};
+
+/* CLASS StaticDumpVisitor ****************************************************/
+
+/**
+ * @class StaticDumpVisitor
+ * Static counterpart of DumpVisitor, to be used with TopVariant
+ */
+class StaticDumpVisitor {
+ public:
+  // Constructors
+  explicit StaticDumpVisitor(Sink &sink = *StreamSink::standard())
+      : _sink(sink) {
+  }
+
+  // Operators
+  void operator()(Baz &top) const {
+    top.dump(_sink);
+  }
+
+  void operator()(BarDerived &top) const {
+    top.dump(_sink);
+  }
+
+  void operator()(BarReusing &top) const {
+    top.dump(_sink);
+  }
+
+ private:
+  // Instance variables
+  Sink &_sink;
+};
+
+#endif  // ARCHITECTURE_HPP_
@@ -0,0 +1,12 @@
+#!/usr/bin/env bash
+
+CXX=${CXX:-g++} 
+CFLAGS=${CFLAGS:- -O2 -DNDEBUG -Wall -Wextra -Werror -pedantic -Wcast-align -Wcast-qual -Wformat=2 -Winit-self -Wlogical-op -Wmissing-include-dirs -Woverloaded-virtual -Wredundant-decls -Wshadow } 
+
+# Compile file
+if [ bench.sh -nt benchmark ] || [ benchmark.cpp -nt benchmark ] || [ architecture.hpp -nt benchmark ];
+    then ${CXX} -std=c++14 ${CFLAGS} benchmark.cpp -o benchmark -pthread || exit 1
+fi
+
+# Run benchmarks (arguments: [iterations] [max_threads])
+./benchmark "$@"
@@ -0,0 +1,843 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//                    calls/sec and ns/call for each front-end                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//                   ./benchmark [iterations] [max_threads]                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+// Standard headers
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <iomanip>
+
+// Internal headers
+#include "architecture.hpp"
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                BENCHMARK MODELS
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+// Every benchmarked call ends up adding to this counter, so the optimizer
+// cannot discard the calls, and threads do not share its cache line.
+thread_local std::size_t sink = 0;
+
+/* CLASS BarBench *************************************************************/
+
+// Forward declaration
+class BarBench;
+
+// Alias
+using BarBenchPtr = std::shared_ptr<BarBench>;
+
+/**
+ * @class BarBench
+ * BarDerived whose Foo methods do no I/O, to measure only the dispatch
+ */
+class BarBench : public BarDerived {
+ public:
+  // Alias
+  using Base = BarDerived;
+
+  using Self = BarBench;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return SelfPtr(new Self(std::forward<Args>(args)...));
+  }
+
+  // Overriden methods
+  using Base::method;
+
+  void method(const SimpleFoo<Target, BarDerived> &/* simple_foo */,
+              const std::string &msg) const override {
+    sink += msg.size();
+  }
+
+  void method(const CachedFoo<Target, BarDerived> &/* cached_foo */,
+              const std::string &msg) const override {
+    sink += msg.size() + 1;
+  }
+
+  void method(const SimpleFoo<Spot, BarDerived> &/* simple_foo */,
+              const std::string &msg) const override {
+    sink += msg.size();
+  }
+
+  void method(const CachedFoo<Spot, BarDerived> &/* cached_foo */,
+              const std::string &msg) const override {
+    sink += msg.size() + 1;
+  }
+
+ protected:
+  // Constructor inheritance
+  using Base::BarDerived;
+};
+
+/* CLASS BarCaching ***********************************************************/
+
+// Forward declaration
+class BarCaching;
+
+// Alias
+using BarCachingPtr = std::shared_ptr<BarCaching>;
+
+/**
+ * @class BarCaching
+ * BarBench whose cached Foo method looks the message up in the cache of the
+ * front-end, shared by all threads
+ */
+class BarCaching : public BarBench {
+ public:
+  // Alias
+  using Base = BarBench;
+
+  using Self = BarCaching;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return SelfPtr(new Self(std::forward<Args>(args)...));
+  }
+
+  // Overriden methods
+  using Base::method;
+
+  void method(const CachedFoo<Target, BarDerived> &cached_foo,
+              const std::string &msg) const override {
+    sink += cached_foo.memoize(msg, [&] { return messageWeight(msg); });
+  }
+
+ protected:
+  // Constructor inheritance
+  using Base::BarBench;
+};
+
+/* CLASS BarSharing ***********************************************************/
+
+// Forward declaration
+class BarSharing;
+
+// Alias
+using BarSharingPtr = std::shared_ptr<BarSharing>;
+
+/**
+ * @class BarSharing
+ * BarBench receiving its Foo front-ends by std::shared_ptr (the borrowing
+ * overrides of BarBench only bind front-ends of BarDerived), as the baseline
+ * of the borrowed mode
+ */
+class BarSharing : public BarBench {
+ public:
+  // Alias
+  using Base = BarBench;
+
+  using Self = BarSharing;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return SelfPtr(new Self(std::forward<Args>(args)...));
+  }
+
+  // Concrete methods
+  using Base::method;
+
+  void method(SimpleFooPtr<Target, BarSharing> /* simple_foo */,
+              const std::string &msg) const {
+    sink += msg.size();
+  }
+
+  void method(CachedFooPtr<Target, BarSharing> /* cached_foo */,
+              const std::string &msg) const {
+    sink += msg.size() + 1;
+  }
+
+  void method(SimpleFooPtr<Target, BarSharing> simple_foo,
+              Span<std::string> msgs) const {
+    for (const auto &msg : msgs) method(simple_foo, msg);
+  }
+
+  void method(CachedFooPtr<Target, BarSharing> cached_foo,
+              Span<std::string> msgs) const {
+    for (const auto &msg : msgs) method(cached_foo, msg);
+  }
+
+ protected:
+  // Constructor inheritance
+  using Base::BarBench;
+};
+
+/* CLASS BazSharing ***********************************************************/
+
+// Forward declaration
+class BazSharing;
+
+// Alias
+using BazSharingPtr = std::shared_ptr<BazSharing>;
+
+/**
+ * @class BazSharing
+ * Baz receiving its Creator front-end by std::shared_ptr, as the baseline of
+ * the borrowed mode
+ */
+class BazSharing : public Baz {
+ public:
+  // Alias
+  using Base = Baz;
+
+  using Self = BazSharing;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return SelfPtr(new Self(std::forward<Args>(args)...));
+  }
+
+  static SelfPtr create(CreatorPtr<Target, Self> creator, creator_space_tag) {
+    return Self::make(buildMessage(creator->words(), " "));
+  }
+
+ protected:
+  // Constructor inheritance
+  using Base::Baz;
+};
+
+/* CLASS BarHandling **********************************************************/
+
+// Forward declaration
+template<typename HandlePolicy>
+class BarHandling;
+
+// Alias
+template<typename HandlePolicy>
+using BarHandlingPtr = std::shared_ptr<BarHandling<HandlePolicy>>;
+
+/**
+ * @class BarHandling
+ * Bar whose Foo methods do no I/O and whose states are traversed by its own
+ * accept, with the handles of the given policy (to measure their cost)
+ */
+template<typename HandlePolicy>
+class BarHandling : public BarCrtp<BarHandling<HandlePolicy>, HandlePolicy> {
+ public:
+  // Alias
+  using Base = BarCrtp<BarHandling<HandlePolicy>, HandlePolicy>;
+
+  using Self = BarHandling;
+  using SelfPtr = std::shared_ptr<Self>;
+
+  template<typename T>
+  using Handle = typename Base::template Handle<T>;
+
+  // Static methods
+  template<typename... Args>
+  static SelfPtr make(Args&&... args) {
+    return HandlePolicy::own(new Self(std::forward<Args>(args)...));
+  }
+
+  // Concrete methods (the borrowing ones are private, so the member
+  // delegator falls back to the handles)
+  void method(Handle<SimpleFoo<Target, Self>> /* simple_foo */,
+              const std::string &msg) const {
+    sink += msg.size();
+  }
+
+  void method(Handle<CachedFoo<Target, Self>> /* cached_foo */,
+              const std::string &msg) const {
+    sink += msg.size() + 1;
+  }
+
+  void method(Handle<SimpleFoo<Target, Self>> simple_foo,
+              Span<std::string> msgs) const {
+    for (const auto &msg : msgs) method(simple_foo, msg);
+  }
+
+  void method(Handle<CachedFoo<Target, Self>> cached_foo,
+              Span<std::string> msgs) const {
+    for (const auto &msg : msgs) method(cached_foo, msg);
+  }
+
+  void method(Handle<SimpleFoo<Spot, Self>> /* simple_foo */,
+              const std::string &msg) const {
+    sink += msg.size();
+  }
+
+  void method(Handle<CachedFoo<Spot, Self>> /* cached_foo */,
+              const std::string &msg) const {
+    sink += msg.size() + 1;
+  }
+
+  void method(Handle<SimpleFoo<Spot, Self>> simple_foo,
+              Span<std::string> msgs) const {
+    for (const auto &msg : msgs) method(simple_foo, msg);
+  }
+
+  void method(Handle<CachedFoo<Spot, Self>> cached_foo,
+              Span<std::string> msgs) const {
+    for (const auto &msg : msgs) method(cached_foo, msg);
+  }
+
+  using Base::accept;
+
+  // Each state receives its own copy of the acceptor handle, as in a
+  // recursive traversal
+  void accept(Handle<SimpleAcceptor<Self>> acceptor,
+              const Acceptor::traversal& type) override {
+    sink++;
+    for (const auto &state : _states) state->accept(acceptor, type);
+  }
+
+  // Concrete methods
+  void add_state(const SelfPtr &state) {
+    _states.push_back(state->handle());
+  }
+
+ protected:
+  // Instance variables
+  std::vector<Handle<Self>> _states;
+
+ private:
+  // Borrowing methods
+  using Base::method;
+};
+
+/* CLASS SinkVisitor **********************************************************/
+
+/**
+ * @class SinkVisitor
+ * Thread-safe visitor that only counts the nodes, to measure the traversal
+ */
+class SinkVisitor : public Visitor {
+ public:
+  // Overriden methods
+  void visit(std::shared_ptr<Baz> /* top */) override {
+    sink++;
+  }
+
+  void visit(std::shared_ptr<BarDerived> /* top */) override {
+    sink++;
+  }
+
+  void visit(std::shared_ptr<BarReusing> /* top */) override {
+    sink++;
+  }
+
+  bool thread_safe() const override {
+    return true;
+  }
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                BENCHMARK RUNNER
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* CLASS Benchmark ************************************************************/
+
+/**
+ * @class Benchmark
+ * Runs one front-end path on N threads at the same time and prints its
+ * aggregated throughput (calls/sec) and per-thread latency (ns/call)
+ */
+class Benchmark {
+ public:
+  // Alias
+  using Clock = std::chrono::steady_clock;
+
+  // Constructors
+  explicit Benchmark(std::size_t iterations)
+      : _iterations(iterations) {
+  }
+
+  // Concrete methods
+  void header() const {
+    std::cout << std::left << std::setw(36) << "path"
+              << std::right << std::setw(8) << "threads"
+              << std::setw(16) << "calls/sec"
+              << std::setw(12) << "ns/call" << std::endl;
+  }
+
+  // The factory is called once per thread (before the clock starts), and
+  // must return the callable to be repeated `iterations / weight` times by it
+  template<typename Factory>
+  void run(const std::string &path, unsigned int threads,
+           Factory factory, std::size_t weight = 1) const {
+    std::size_t iterations = std::max<std::size_t>(1, _iterations / weight);
+    std::atomic<unsigned int> ready(0);
+    std::atomic<bool> go(false);
+
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < threads; t++) {
+      workers.emplace_back([iterations, &factory, &ready, &go] {
+        auto call = factory();
+        ready++;
+        while (!go) std::this_thread::yield();
+        for (std::size_t i = 0; i < iterations; i++) call();
+      });
+    }
+
+    while (ready != threads) std::this_thread::yield();
+    auto begin = Clock::now();
+    go = true;
+    for (auto &worker : workers) worker.join();
+    auto end = Clock::now();
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    double calls = static_cast<double>(iterations) * threads;
+
+    std::cout << std::left << std::setw(36) << path
+              << std::right << std::setw(8) << threads
+              << std::setw(16) << std::fixed << std::setprecision(0)
+              << calls / seconds
+              << std::setw(12) << std::setprecision(2)
+              << seconds * 1e9 * threads / calls << std::endl;
+  }
+
+ private:
+  // Instance variables
+  std::size_t _iterations;
+};
+
+/*
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+ -------------------------------------------------------------------------------
+                                      MAIN
+ -------------------------------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+*/
+
+/* FUNCTION main **************************************************************/
+
+int main(int argc, char **argv) {
+  std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                    : 1000000;
+
+  unsigned int max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10)
+                                      : std::thread::hardware_concurrency();
+  if (max_threads == 0) max_threads = 1;
+
+  std::vector<unsigned int> thread_counts = { 1 };
+  if (max_threads > 1) thread_counts.push_back(max_threads);
+
+  // One model (and front-end) shared by all threads
+  auto model = BarBench::make();
+  FooPtr<Target> simple_foo = model->targetFoo(false);
+  FooPtr<Target> cached_foo = model->targetFoo(true);
+  auto direct_foo = std::make_shared<SimpleFoo<Target, BarDerived>>(model);
+
+  auto caching_model = BarCaching::make();
+  FooPtr<Target> caching_foo = caching_model->targetFoo(true);
+
+  // Messages already in the caches, read by every thread
+  std::vector<std::string> cached_msgs;
+  for (unsigned int i = 0; i < 64; i++)
+    cached_msgs.push_back("msg" + std::to_string(i));
+  BarDerived::Cache concurrent_cache;
+  MemoTable<std::string, double> locked_cache;
+  std::mutex locked_cache_mutex;
+  for (const auto &cached_msg : cached_msgs) {
+    caching_foo->method(cached_msg);
+    concurrent_cache.get(cached_msg, [] { return 1.0; });
+    locked_cache.get(cached_msg, [] { return 1.0; });
+  }
+
+  auto sharing_model = BarSharing::make();
+  auto sharing_simple_foo
+    = std::make_shared<SimpleFoo<Target, BarSharing>>(sharing_model);
+  auto sharing_cached_foo
+    = std::make_shared<CachedFoo<Target, BarSharing>>(sharing_model);
+
+  auto creator = Baz::targetCreator();
+  auto sharing_creator = SimpleCreator<Target, BazSharing>::make();
+  auto memoizing_creator
+    = CachedCreator<Target, Baz, creator_space_tag>::make(creator_space_tag{});
+  memoizing_creator->memoizing(true);
+  StaticCreator<Target, Baz, simple_strategy> static_creator;
+  for (const auto &word : { "This", "is", "a", "text" }) {
+    creator->add_word(word);
+    sharing_creator->add_word(word);
+    memoizing_creator->add_word(word);
+    static_creator.add_word(word);
+  }
+
+  std::vector<BarDerivedPtr> states;
+  for (unsigned int i = 0; i < 64; i++)
+    states.push_back(BarDerived::make("state"));
+  auto composite = BarDerived::make("composite", states);
+
+  std::vector<BarDerivedPtr> big_states;
+  for (unsigned int i = 0; i < 64; i++)
+    big_states.push_back(BarDerived::make("state", states));
+  auto big_composite = BarDerived::make("composite", big_states);
+
+  auto flat_composite = FlatComposite::compile(*big_composite);
+
+  // Models with 64 states each, handing out the handles of every policy
+  using SharedHandling = BarHandling<shared_handles>;
+  using AtomicHandling = BarHandling<intrusive_handles<atomic_refcount>>;
+  using PlainHandling = BarHandling<intrusive_handles<plain_refcount>>;
+  auto shared_handling = SharedHandling::make();
+  auto atomic_handling = AtomicHandling::make();
+  auto plain_handling = PlainHandling::make();
+  for (unsigned int i = 0; i < 64; i++) {
+    shared_handling->add_state(SharedHandling::make());
+    atomic_handling->add_state(AtomicHandling::make());
+    plain_handling->add_state(PlainHandling::make());
+  }
+  FooPtr<Target> shared_handling_foo = shared_handling->targetFoo(false);
+  FooPtr<Target> atomic_handling_foo = atomic_handling->targetFoo(false);
+  FooPtr<Target> plain_handling_foo = plain_handling->targetFoo(false);
+
+  auto deep_composite = BarDerived::make("state");
+  for (unsigned int i = 0; i < 4096; i++)
+    deep_composite = BarDerived::make("state", std::vector<BarDerivedPtr>{
+      deep_composite });
+
+  auto fixed_creator = BarDerived::targetCreator(composite);
+
+  const std::string msg = "msg";
+  const std::vector<std::string> msgs(64, msg);
+
+  Benchmark benchmark(iterations);
+  benchmark.header();
+
+  for (unsigned int threads : thread_counts) {
+    benchmark.run("SimpleFoo::method (delegator)", threads, [&] {
+      return [&] { simple_foo->method(msg); };
+    });
+
+    benchmark.run("CachedFoo::method (delegator)", threads, [&] {
+      return [&] { cached_foo->method(msg); };
+    });
+
+    benchmark.run("SimpleFoo::method (64 msgs/call)", threads, [&] {
+      return [&] { simple_foo->method(msgs); };
+    }, 64);
+
+    benchmark.run("CachedFoo::method (64 msgs/call)", threads, [&] {
+      return [&] { cached_foo->method(msgs); };
+    }, 64);
+
+    benchmark.run("SimpleFoo::method (shared)", threads, [&] {
+      return [&] { sharing_simple_foo->method(msg); };
+    });
+
+    benchmark.run("CachedFoo::method (shared)", threads, [&] {
+      return [&] { sharing_cached_foo->method(msg); };
+    });
+
+    // Each call hits one of 64 cached messages, in a cache shared by all
+    // threads: concurrent lookups write nothing, a locked one takes a mutex
+    benchmark.run("CachedFoo::method (shared cache)", threads, [&] {
+      return [&, i = std::size_t(0)]() mutable {
+        caching_foo->method(cached_msgs[i++ % cached_msgs.size()]);
+      };
+    });
+
+    benchmark.run("ConcurrentMemoTable::get (hit)", threads, [&] {
+      return [&, i = std::size_t(0)]() mutable {
+        sink += concurrent_cache.get(
+          cached_msgs[i++ % cached_msgs.size()], [] { return 0.0; });
+      };
+    });
+
+    benchmark.run("MemoTable::get (hit, locked)", threads, [&] {
+      return [&, i = std::size_t(0)]() mutable {
+        std::lock_guard<std::mutex> lock(locked_cache_mutex);
+        sink += locked_cache.get(
+          cached_msgs[i++ % cached_msgs.size()], [] { return 0.0; });
+      };
+    });
+
+    benchmark.run("BarCrtp::method (direct)", threads, [&] {
+      return [&] { model->method(*direct_foo, msg); };
+    });
+
+    benchmark.run("Creator::create (delegator)", threads, [&] {
+      return [&] { sink += creator->create(creator_space_tag{}) != nullptr; };
+    });
+
+    benchmark.run("Creator::create (shared)", threads, [&] {
+      return [&] {
+        sink += sharing_creator->create(creator_space_tag{}) != nullptr;
+      };
+    });
+
+    benchmark.run("StaticCreator::create", threads, [&] {
+      return [&] {
+        sink += static_creator.create(creator_space_tag{}) != nullptr;
+      };
+    });
+
+    benchmark.run("Creator::create (memoized)", threads, [&] {
+      return [&] { sink += memoizing_creator->create() != nullptr; };
+    });
+
+    // Each call hands out a copy of a predefined composite of 65 nodes
+    benchmark.run("Creator::create (fixed)", threads, [&] {
+      return [&] { sink += fixed_creator->create()->composite_size(); };
+    });
+
+    // Each call visits the composite and its 64 states
+    benchmark.run("Acceptor::accept (65 nodes)", threads, [&] {
+      auto visitor = std::make_shared<SinkVisitor>();
+      return [&composite, visitor] {
+        composite->acceptor(visitor)->accept(Acceptor::traversal::pre_order);
+      };
+    }, 64);
+
+    benchmark.run("TopVariant::accept (65 nodes)", threads, [&] {
+      TopVariant top(composite);
+      return [top] {
+        top.accept([](auto& /* top */) { sink++; },
+                   Acceptor::traversal::pre_order);
+      };
+    }, 64);
+
+    // Each call visits 4161 nodes from one thread, with the subtrees of 65
+    // nodes as tasks for the workers
+    WorkStealingPool pool(threads);
+    std::string workers = std::to_string(threads) + " workers";
+    benchmark.run("Acceptor::accept (4161, " + workers + ")", 1, [&] {
+      auto visitor = std::make_shared<SinkVisitor>();
+      return [&big_composite, &pool, visitor] {
+        big_composite->acceptor(visitor)->pre_order(pool, 64);
+      };
+    }, 4096);
+
+    benchmark.run("FlatComposite::pre_order (4161)", threads, [&] {
+      return [&flat_composite] {
+        flat_composite.pre_order(
+          [](const FlatComposite::Node& /* node */, Span<char> text) {
+            sink += text.size();
+          });
+      };
+    }, 4096);
+
+    benchmark.run("FlatComposite::post_order (4161)", threads, [&] {
+      return [&flat_composite] {
+        flat_composite.post_order(
+          [](const FlatComposite::Node& /* node */, Span<char> text) {
+            sink += text.size();
+          });
+      };
+    }, 4096);
+
+    // Each call dumps 4161 nodes into /dev/null, with one write per text
+    // (as flushing after each node), batched writes or a background writer
+    benchmark.run("DumpVisitor (4161, unbuffered)", threads, [&] {
+      auto visitor = DumpVisitor::make(FileSink::make("/dev/null", 1));
+      return [&big_composite, visitor] {
+        big_composite->acceptor(visitor)->pre_order();
+      };
+    }, 4096);
+
+    benchmark.run("DumpVisitor (4161, buffered)", threads, [&] {
+      auto visitor = DumpVisitor::make(FileSink::make("/dev/null"));
+      return [&big_composite, visitor] {
+        big_composite->acceptor(visitor)->pre_order();
+      };
+    }, 4096);
+
+    benchmark.run("DumpVisitor (4161, asynchronous)", threads, [&] {
+      auto visitor = DumpVisitor::make(
+        AsyncSink::make(FileSink::make("/dev/null")));
+      return [&big_composite, visitor] {
+        big_composite->acceptor(visitor)->pre_order();
+      };
+    }, 4096);
+
+    // Each call builds a composite of 64 states from 1024 words, with new
+    // creators (as they keep the words received)
+    auto create_composite = [](const parallel_policy *policy) {
+      std::vector<CreatorPtr<Target, BarDerived::State>> state_creators;
+      for (unsigned int i = 0; i < 64; i++)
+        state_creators.push_back(
+          BarDerived::targetCreator(creator_space_tag{}));
+
+      auto composite_creator = policy
+        ? BarDerived::targetCreator(creator_space_tag{}, state_creators,
+                                    *policy)
+        : BarDerived::targetCreator(creator_space_tag{}, state_creators);
+      for (unsigned int i = 0; i < 1024; i++)
+        composite_creator->add_word("word");
+      sink += composite_creator->create()->composite_size();
+    };
+
+    benchmark.run("BarDerived::create (64 states)", threads, [&] {
+      return [&create_composite] { create_composite(nullptr); };
+    }, 4096);
+
+    parallel_policy policy{pool};
+    benchmark.run("BarDerived::create (64, " + workers + ")", 1, [&] {
+      return [&create_composite, &policy] { create_composite(&policy); };
+    }, 4096);
+
+    // Each call fans out 64 asynchronous calls to 8 models, coalesced into
+    // batches by the executor, and waits for all of them
+    BatchingExecutor executor(pool);
+    benchmark.run("AsyncFoo::method (64, " + workers + ")", 1, [&] {
+      std::vector<AsyncFoo<Target>> async_foos;
+      for (unsigned int i = 0; i < 8; i++)
+        async_foos.emplace_back(BarBench::make()->targetFoo(false), executor);
+      return [async_foos, &msg] {
+        std::vector<std::future<void>> futures;
+        for (unsigned int i = 0; i < 64; i++)
+          futures.push_back(async_foos[i % async_foos.size()].method(msg));
+        for (auto &future : futures) future.get();
+      };
+    }, 64);
+
+    // Each call loads the 4161 nodes of an image held in memory
+    benchmark.run("ModelImage::load (4161 nodes)", threads, [&] {
+      auto image = BufferSink::make();
+      ModelImage::save(TopVariant(big_composite), *image);
+      return [image] {
+        auto top = ModelImage::load(
+          Span<char>(image->str().data(), image->str().size()), image);
+        sink += static_cast<std::size_t>(top.which());
+      };
+    }, 4096);
+
+    // Each call builds (and releases) a composite of 64 states, from the
+    // heap or from an arena of its own
+    benchmark.run("BarDerived::make (65 nodes)", threads, [&] {
+      return [] {
+        std::vector<BarDerivedPtr> heap_states;
+        for (unsigned int i = 0; i < 64; i++)
+          heap_states.push_back(BarDerived::make("state"));
+        sink += BarDerived::make("composite", heap_states)->composite_size();
+      };
+    }, 64);
+
+    benchmark.run("make_allocated (65 nodes, arena)", threads, [&] {
+      return [] {
+        ArenaAllocator<char> allocator(MonotonicArena::make());
+        std::vector<BarDerivedPtr> arena_states;
+        for (unsigned int i = 0; i < 64; i++)
+          arena_states.push_back(
+            make_allocated<BarDerived>(allocator, "state"));
+        sink += make_allocated<BarDerived>(
+          allocator, "composite", arena_states)->composite_size();
+      };
+    }, 64);
+
+    // Texts and states vectors are taken from the arena too, locking it or
+    // not (LocalArena, one per call)
+    benchmark.run("BarDerived::make (65, arena)", threads, [&] {
+      return [] {
+        ArenaAllocator<char> allocator(MonotonicArena::make());
+        std::vector<BarDerivedPtr> arena_states;
+        for (unsigned int i = 0; i < 64; i++)
+          arena_states.push_back(
+            BarDerived::make(std::allocator_arg, allocator, "state"));
+        sink += BarDerived::make(
+          std::allocator_arg, allocator, "composite", arena_states
+        )->composite_size();
+      };
+    }, 64);
+
+    benchmark.run("BarDerived::make (65, local arena)", threads, [&] {
+      return [] {
+        ArenaAllocator<char, LocalArena> allocator(LocalArena::make());
+        std::vector<BarDerivedPtr> arena_states;
+        for (unsigned int i = 0; i < 64; i++)
+          arena_states.push_back(
+            BarDerived::make(std::allocator_arg, allocator, "state"));
+        sink += BarDerived::make(
+          std::allocator_arg, allocator, "composite", arena_states
+        )->composite_size();
+      };
+    }, 64);
+
+    // Each call delegates to a model receiving the front-end handle of a
+    // policy: std::shared_ptr, or intrusive counting atomically or not (the
+    // latter confined to one thread)
+    benchmark.run("Foo::method (shared handles)", threads, [&] {
+      return [&] { shared_handling_foo->method(msg); };
+    });
+
+    benchmark.run("Foo::method (atomic intrusive)", threads, [&] {
+      return [&] { atomic_handling_foo->method(msg); };
+    });
+
+    if (threads == 1) {
+      benchmark.run("Foo::method (plain intrusive)", threads, [&] {
+        return [&] { plain_handling_foo->method(msg); };
+      });
+    }
+
+    // Each call asks a model for its front-end, which takes the model as a
+    // std::shared_ptr (aliasing its owner with the intrusive policies)
+    benchmark.run("Bar::targetFoo (shared)", threads, [&] {
+      return [&] { sink += shared_handling->targetFoo(false) != nullptr; };
+    });
+
+    benchmark.run("Bar::targetFoo (atomic)", threads, [&] {
+      return [&] { sink += atomic_handling->targetFoo(false) != nullptr; };
+    });
+
+    if (threads == 1) {
+      benchmark.run("Bar::targetFoo (plain)", threads, [&] {
+        return [&] { sink += plain_handling->targetFoo(false) != nullptr; };
+      });
+    }
+
+    // Each call traverses a model and its 64 states, copying the acceptor
+    // handle of each policy for every state
+    benchmark.run("Acceptor::accept (65, shared)", threads, [&] {
+      auto visitor = std::make_shared<SinkVisitor>();
+      return [&shared_handling, visitor] {
+        shared_handling->acceptor(visitor)->pre_order();
+      };
+    }, 64);
+
+    benchmark.run("Acceptor::accept (65, atomic)", threads, [&] {
+      auto visitor = std::make_shared<SinkVisitor>();
+      return [&atomic_handling, visitor] {
+        atomic_handling->acceptor(visitor)->pre_order();
+      };
+    }, 64);
+
+    if (threads == 1) {
+      benchmark.run("Acceptor::accept (65, plain)", threads, [&] {
+        auto visitor = std::make_shared<SinkVisitor>();
+        return [&plain_handling, visitor] {
+          plain_handling->acceptor(visitor)->pre_order();
+        };
+      }, 64);
+    }
+
+    // Each call visits a chain of 4097 nested states
+    benchmark.run("Acceptor::accept (4097 deep)", threads, [&] {
+      auto visitor = std::make_shared<SinkVisitor>();
+      return [&deep_composite, visitor] {
+        deep_composite->acceptor(visitor)->accept(
+          Acceptor::traversal::post_order);
+      };
+    }, 4096);
+  }
+
+#ifdef ARCHITECTURE_PROFILE
+  CallProfiler::instance().report();
+#endif
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+#!/usr/bin/env bash
+
+CXX=${CXX:-g++}
+CFLAGS=${CFLAGS:- -O2 -DNDEBUG -Wall -Wextra -Werror -pedantic }
+
+# Arguments: [models] [front_ends] [header]
+MODELS=${1:-20}
+FRONT_ENDS=${2:-20}
+HEADER=$(realpath "${3:-architecture.hpp}")
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "${WORKDIR}"' EXIT
+
+# Synthesize a translation unit with MODELS models (each one at the end of a
+# 4-level Base chain) and FRONT_ENDS front-end methods, querying the member
+# detectors for every model/front-end pair. Only the detector and delegator
+# macros of the header (the sections between its MEMBER DETECTER and COMMON
+# CLASSES banners) are copied, with the standard headers they need, so the
+# rest of the header is not measured
+{
+  for STD in memory tuple utility stdexcept type_traits; do
+    echo "#include <${STD}>"
+  done
+  echo
+
+  awk '
+    /MEMBER DETECTER/ { state = 1; next }
+    state == 1 && /^\*\/$/ { state = 2; next }
+    state == 2 && /COMMON CLASSES/ {
+      for (i = 1; i <= n - 3; i++) print lines[i]  # Without the next banner
+      exit
+    }
+    state == 2 { lines[++n] = $0 }
+  ' "${HEADER}"
+  echo
+
+  for ((j = 0; j < FRONT_ENDS; j++)); do
+    echo "GENERATE_HAS_MEMBER_FUNCTION(method${j});"
+    echo "GENERATE_HAS_STATIC_MEMBER_FUNCTION(create${j});"
+  done
+  echo
+
+  for ((i = 0; i < MODELS; i++)); do
+    for ((level = 0; level < 4; level++)); do
+      if [ ${level} -eq 0 ]; then
+        echo "struct Model${i}L0 { using Base = void;"
+      else
+        echo "struct Model${i}L${level} : Model${i}L$((level - 1)) {"
+        echo "  using Base = Model${i}L$((level - 1));"
+      fi
+      for ((j = 0; j < FRONT_ENDS; j++)); do
+        if [ $(((i + j) % 3)) -ne 0 ] && [ $(((i + j) % 4)) -eq ${level} ]; then
+          echo "  void method${j}(int) {}"
+          echo "  static int create${j}(double) { return 0; }"
+        fi
+      done
+      echo "};"
+    done
+    echo "using Model${i} = Model${i}L3;"
+    echo
+  done
+
+  for ((i = 0; i < MODELS; i++)); do
+    for ((j = 0; j < FRONT_ENDS; j++)); do
+      if [ $(((i + j) % 3)) -ne 0 ]; then NOT=""; else NOT="!"; fi
+      echo "static_assert(${NOT}has_member_function_method${j}<"
+      echo "  Model${i}, void(int)>::value, \"\");"
+      echo "static_assert(${NOT}has_static_member_function_create${j}<"
+      echo "  Model${i}, int(double)>::value, \"\");"
+    done
+  done
+} > "${WORKDIR}/detectors.cpp"
+
+# Compile it, dumping the layout of every instantiated class
+cd "${WORKDIR}" || exit 1
+START=$(date +%s%N)
+${CXX} -std=c++14 ${CFLAGS} -fdump-lang-class -c detectors.cpp -o detectors.o \
+  || exit 1
+END=$(date +%s%N)
+
+# Report (the class dump has one "Class" entry per instantiated class)
+echo "models:          ${MODELS}"
+echo "front-ends:      ${FRONT_ENDS}"
+echo "compile time:    $(((END - START) / 1000000)) ms"
+echo "classes:         $(grep -c '^Class ' detectors.cpp.*.class)"
+echo "object size:     $(stat -c %s detectors.o) bytes"
@@ -8,8 +8,8 @@ CXX=${CXX:-g++}
 CFLAGS=${CFLAGS:- -Wall -Wextra -Werror -pedantic -Wcast-align -Wcast-qual -Wformat=2 -Winit-self -Wlogical-op -Wmissing-include-dirs -Woverloaded-virtual -Wredundant-decls -Wshadow } 
 
 # Compile file
-if [ test.sh -nt architecture ] || [ architecture.cpp -nt architecture ];
-    then valgrind -q ${CXX} -std=c++14 ${CFLAGS} architecture.cpp -o architecture || exit 1
+if [ test.sh -nt architecture ] || [ architecture.cpp -nt architecture ] || [ architecture.hpp -nt architecture ];
+    then valgrind -q ${CXX} -std=c++14 ${CFLAGS} architecture.cpp -o architecture -pthread || exit 1
 fi
 
 # Run tests